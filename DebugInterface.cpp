@@ -1,102 +1,160 @@
 #include "DebugInterface.hpp"
 #include "codegame/ClientMessage.hpp"
 
-DebugInterface::DebugInterface(TcpStream* stream): stream(stream) {}
+DebugInterface::DebugInterface(TcpStream* stream): stream(stream), async(false) {}
+
+DebugInterface::~DebugInterface()
+{
+    waitSent();
+}
 
 void DebugInterface::addPlacedText(model::Vec2 position, std::string text, model::Vec2 alignment, double size, debugging::Color color)
 {
-    add(std::shared_ptr<debugging::DebugData>(new debugging::DebugData::PlacedText(position, text, alignment, size, color)));
+    add(debugging::DebugData::PlacedText(position, text, alignment, size, color));
 }
 
 void DebugInterface::addCircle(model::Vec2 position, double radius, debugging::Color color)
 {
-    add(std::shared_ptr<debugging::DebugData>(new debugging::DebugData::Circle(position, radius, color)));
+    add(debugging::DebugData::Circle(position, radius, color));
 }
 
 void DebugInterface::addGradientCircle(model::Vec2 position, double radius, debugging::Color innerColor, debugging::Color outerColor)
 {
-    add(std::shared_ptr<debugging::DebugData>(new debugging::DebugData::GradientCircle(position, radius, innerColor, outerColor)));
+    add(debugging::DebugData::GradientCircle(position, radius, innerColor, outerColor));
 }
 
 void DebugInterface::addRing(model::Vec2 position, double radius, double width, debugging::Color color)
 {
-    add(std::shared_ptr<debugging::DebugData>(new debugging::DebugData::Ring(position, radius, width, color)));
+    add(debugging::DebugData::Ring(position, radius, width, color));
 }
 
 void DebugInterface::addPie(model::Vec2 position, double radius, double startAngle, double endAngle, debugging::Color color)
 {
-    add(std::shared_ptr<debugging::DebugData>(new debugging::DebugData::Pie(position, radius, startAngle, endAngle, color)));
+    add(debugging::DebugData::Pie(position, radius, startAngle, endAngle, color));
 }
 
 void DebugInterface::addArc(model::Vec2 position, double radius, double width, double startAngle, double endAngle, debugging::Color color)
 {
-    add(std::shared_ptr<debugging::DebugData>(new debugging::DebugData::Arc(position, radius, width, startAngle, endAngle, color)));
+    add(debugging::DebugData::Arc(position, radius, width, startAngle, endAngle, color));
 }
 
 void DebugInterface::addRect(model::Vec2 bottomLeft, model::Vec2 size, debugging::Color color)
 {
-    add(std::shared_ptr<debugging::DebugData>(new debugging::DebugData::Rect(bottomLeft, size, color)));
+    add(debugging::DebugData::Rect(bottomLeft, size, color));
 }
 
 void DebugInterface::addPolygon(std::vector<model::Vec2> vertices, debugging::Color color)
 {
-    add(std::shared_ptr<debugging::DebugData>(new debugging::DebugData::Polygon(vertices, color)));
+    add(debugging::DebugData::Polygon(vertices, color));
 }
 
 void DebugInterface::addGradientPolygon(std::vector<debugging::ColoredVertex> vertices)
 {
-    add(std::shared_ptr<debugging::DebugData>(new debugging::DebugData::GradientPolygon(vertices)));
+    add(debugging::DebugData::GradientPolygon(vertices));
 }
 
 void DebugInterface::addSegment(model::Vec2 firstEnd, model::Vec2 secondEnd, double width, debugging::Color color)
 {
-    add(std::shared_ptr<debugging::DebugData>(new debugging::DebugData::Segment(firstEnd, secondEnd, width, color)));
+    add(debugging::DebugData::Segment(firstEnd, secondEnd, width, color));
 }
 
 void DebugInterface::addGradientSegment(model::Vec2 firstEnd, debugging::Color firstColor, model::Vec2 secondEnd, debugging::Color secondColor, double width)
 {
-    add(std::shared_ptr<debugging::DebugData>(new debugging::DebugData::GradientSegment(firstEnd, firstColor, secondEnd, secondColor, width)));
+    add(debugging::DebugData::GradientSegment(firstEnd, firstColor, secondEnd, secondColor, width));
 }
 
 void DebugInterface::addPolyLine(std::vector<model::Vec2> vertices, double width, debugging::Color color)
 {
-    add(std::shared_ptr<debugging::DebugData>(new debugging::DebugData::PolyLine(vertices, width, color)));
+    add(debugging::DebugData::PolyLine(vertices, width, color));
 }
 
 void DebugInterface::addGradientPolyLine(std::vector<debugging::ColoredVertex> vertices, double width)
 {
-    add(std::shared_ptr<debugging::DebugData>(new debugging::DebugData::GradientPolyLine(vertices, width)));
+    add(debugging::DebugData::GradientPolyLine(vertices, width));
 }
 
-void DebugInterface::add(std::shared_ptr<debugging::DebugData> debugData)
+void DebugInterface::add(debugging::DebugDataValue debugData)
 {
-    send(std::shared_ptr<debugging::DebugCommand>(new debugging::DebugCommand::Add(debugData)));
+    send(debugging::DebugCommand::Add(std::move(debugData)));
 }
 
 void DebugInterface::clear()
 {
-    send(std::shared_ptr<debugging::DebugCommand>(new debugging::DebugCommand::Clear()));
+    send(debugging::DebugCommand::Clear());
 }
 
 void DebugInterface::setAutoFlush(bool enable)
 {
-    send(std::shared_ptr<debugging::DebugCommand>(new debugging::DebugCommand::SetAutoFlush(enable)));
+    send(debugging::DebugCommand::SetAutoFlush(enable));
 }
 
 void DebugInterface::flush()
 {
-    send(std::shared_ptr<debugging::DebugCommand>(new debugging::DebugCommand::Flush()));
+    send(debugging::DebugCommand::Flush());
 }
 
-void DebugInterface::send(std::shared_ptr<debugging::DebugCommand> command)
+void DebugInterface::send(debugging::DebugCommandValue command)
 {
-    codegame::ClientMessage::DebugMessage(command).writeTo(*stream);
-    stream->flush();
+    pending.push_back(std::move(command));
 }
 
 debugging::DebugState DebugInterface::getState()
 {
+    beforeReply();
     codegame::ClientMessage::RequestDebugState().writeTo(*stream);
     stream->flush();
+    afterReply();
     return debugging::DebugState::readFrom(*stream);
+}
+
+void DebugInterface::setAsync(bool enable)
+{
+    async = enable;
+    if (async && !sender.joinable()) {
+        sender = std::jthread([this](std::stop_token stop) {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (condition.wait(lock, stop, [this] { return !sending.empty(); })) {
+                lock.unlock();
+                writeCommands(sending);
+                stream->flush();
+                lock.lock();
+                sending.clear();
+                condition.notify_all();
+            }
+        });
+    }
+}
+
+void DebugInterface::beforeReply()
+{
+    waitSent();
+    if (!async) {
+        writeCommands(pending);
+        pending.clear();
+    }
+}
+
+void DebugInterface::afterReply()
+{
+    if (!async || pending.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    sending.swap(pending);
+    condition.notify_all();
+}
+
+// Same bytes as ClientMessage::DebugMessage, without wrapping the command into a shared_ptr
+void DebugInterface::writeCommands(const std::vector<debugging::DebugCommandValue>& commands)
+{
+    for (const auto& command: commands) {
+        stream->write(codegame::ClientMessage::DebugMessage::TAG);
+        debugging::writeDebugCommandValue(*stream, command);
+    }
+}
+
+void DebugInterface::waitSent()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [this] { return sending.empty(); });
 }
\ No newline at end of file
@@ -4,11 +4,20 @@
 #include "TcpStream.hpp"
 #include "debugging/DebugCommand.hpp"
 #include "debugging/DebugState.hpp"
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
+// Debug commands are buffered for the whole tick instead of being flushed one by one.
+// By default the runner writes them right before its reply, so they go out with the reply's flush.
+// In asynchronous mode they are serialized and sent by a background thread after the reply is flushed,
+// so the decision path never waits for them, but the app shows them with the next tick.
 class DebugInterface {
 public:
     DebugInterface(TcpStream* stream);
+    ~DebugInterface();
 
     void addPlacedText(model::Vec2 position, std::string text, model::Vec2 alignment, double size, debugging::Color color);
     void addCircle(model::Vec2 position, double radius, debugging::Color color);
@@ -23,15 +32,33 @@ public:
     void addGradientSegment(model::Vec2 firstEnd, debugging::Color firstColor, model::Vec2 secondEnd, debugging::Color secondColor, double width);
     void addPolyLine(std::vector<model::Vec2> vertices, double width, debugging::Color color);
     void addGradientPolyLine(std::vector<debugging::ColoredVertex> vertices, double width);
-    void add(std::shared_ptr<debugging::DebugData> debugData);
+    void add(debugging::DebugDataValue debugData);
     void clear();
     void setAutoFlush(bool enable);
     void flush();
-    void send(std::shared_ptr<debugging::DebugCommand> command);
+    void send(debugging::DebugCommandValue command);
     debugging::DebugState getState();
 
+    void setAsync(bool enable);
+    // Called by the runner before writing a reply to the stream and after flushing it
+    void beforeReply();
+    void afterReply();
+
 private:
+    void writeCommands(const std::vector<debugging::DebugCommandValue>& commands);
+    // Blocks until the background thread is done with the stream
+    void waitSent();
+
     TcpStream* stream;
+    bool async;
+    // commands of the current tick
+    std::vector<debugging::DebugCommandValue> pending;
+    // commands handed to the background thread, empty when it does not touch the stream
+    std::vector<debugging::DebugCommandValue> sending;
+    std::mutex mutex;
+    std::condition_variable_any condition;
+    // declared last, so it is stopped before the buffers are destroyed
+    std::jthread sender;
 };
 
 #endif
\ No newline at end of file
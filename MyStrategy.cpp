@@ -1,4 +1,5 @@
 #include "MyStrategy.hpp"
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <exception>
@@ -8,9 +9,16 @@
 #include "emulator/Constants.h"
 #include "emulator/DebugSingleton.h"
 #include "emulator/Evaluation.h"
+#include "emulator/EvaluationPool.h"
 #include "emulator/LootPicker.h"
+#include "emulator/Mcts.h"
 #include "emulator/Memory.h"
+#include "emulator/Navigation.h"
+#include "emulator/Planner.h"
 #include "emulator/Sound.h"
+#include "emulator/Telemetry.h"
+#include "emulator/TimeScheduler.h"
+#include "emulator/Visibility.h"
 #include "emulator/World.h"
 
 MyStrategy::MyStrategy(const model::Constants& constants) {
@@ -20,71 +28,131 @@ MyStrategy::MyStrategy(const model::Constants& constants) {
         emulatorConstants.ticksPerSecond = 15;
     }
     Emulator::SetGlobalConstants(std::move(emulatorConstants));
+    Emulator::BuildGlobalVisibilityMap();
+    Emulator::BuildGlobalNavigationGrid();
 }
 
-model::Order MyStrategy::doGetOrder(const model::Game& game, DebugInterface* debugInterface) {
+model::Order MyStrategy::doGetOrder(const Emulator::TWorld& world, const std::vector<Emulator::TSound>& sounds, DebugInterface* debugInterface) {
+    auto tickStart = std::chrono::high_resolution_clock::now();
+
+    std::vector<Emulator::TUnitUrgency> urgencies;
+    for (const auto& unit: world.Units) {
+        if (unit.PlayerId != world.MyId) {
+            continue;
+        }
+        auto preprocessedData = world.PreprocessedDataById.find(unit.Id);
+        bool inCombat = false;
+        for (const auto& enemy: world.Units) {
+            auto combatRadius = std::max(unit.GetCombatRadius(), enemy.GetCombatRadius());
+            if (enemy.PlayerId != world.MyId && abs2(enemy.Position - unit.Position) < combatRadius * combatRadius) {
+                inCombat = true;
+                break;
+            }
+        }
+        urgencies.push_back({
+            .UnitId = unit.Id,
+            .InDanger = preprocessedData != world.PreprocessedDataById.end() && preprocessedData->second.InDanger,
+            .InCombat = inCombat,
+        });
+    }
+    Emulator::GetGlobalTimeScheduler().BeginTick(urgencies, tickStart);
+
     std::unordered_map<int, model::UnitOrder> actions;
-    for (auto &unit : game.units)
+    for (const auto& unit : world.Units)
     {
-        if (unit.playerId != game.myId)
+        if (unit.PlayerId != world.MyId)
             continue;
 
-        actions.insert({unit.id, getUnitOrder(game, debugInterface, unit)});
+        actions.insert({unit.Id, getUnitOrder(world, sounds, debugInterface, unit)});
     }
 
     return {actions};
 }
 
 model::Order MyStrategy::getOrder(const model::Game& game, DebugInterface* debugInterface) {
-    static auto globalStart = std::chrono::high_resolution_clock::now();
+    std::vector<Emulator::TSound> sounds;
+    for (const auto& sound: game.sounds) {
+        sounds.push_back(Emulator::TSound::FromApi(sound));
+    }
+    return getOrder(Emulator::TWorld::FormApi(game), sounds, debugInterface);
+}
+
+model::Order MyStrategy::getOrder(const Emulator::TWorld& world, const std::vector<Emulator::TSound>& sounds, DebugInterface* debugInterface) {
     auto start = std::chrono::high_resolution_clock::now();
-    auto output = doGetOrder(game, debugInterface);
+    auto output = doGetOrder(world, sounds, debugInterface);
     auto finish = std::chrono::high_resolution_clock::now();
 
-//    std::cout << std::chrono::duration_cast<std::chrono::microseconds>(finish-globalStart).count() / 1000. << "\t";
-//    std::cout << std::chrono::duration_cast<std::chrono::microseconds>(finish-start).count() / 1000. << "\n";
+    Emulator::GetGlobalTelemetry().AddTick(world.CurrentTick, std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count());
 
     return output;
 }
 
-model::UnitOrder MyStrategy::getUnitOrder(const model::Game& game, DebugInterface* debugInterface, const model::Unit& unit) {
+model::UnitOrder MyStrategy::getUnitOrder(const Emulator::TWorld& tickWorld, const std::vector<Emulator::TSound>& sounds, DebugInterface* debugInterface, const Emulator::TUnit& unit) {
     static auto constants = Emulator::GetGlobalConstants();
     static robin_hood::unordered_map<int, std::vector<Emulator::TStrategy>> forcedStrategiesById;
     static Emulator::TMemory memory;
-    auto& forcedStrategies = forcedStrategiesById[unit.id];
+    static robin_hood::unordered_map<int, Emulator::TCrossEntropyPlanner> plannersById;
+    static robin_hood::unordered_map<int, Emulator::TMctsPlanner> mctsPlannersById;
+    static Emulator::TEvaluationPool pool;
+    auto& scheduler = Emulator::GetGlobalTimeScheduler();
+    auto& forcedStrategies = forcedStrategiesById[unit.Id];
+    // the plan carried over from the last tick is forced strategy 0
+    bool hadPlan = !forcedStrategies.empty();
+    auto& planner = plannersById[unit.Id];
+    auto& mctsPlanner = mctsPlannersById[unit.Id];
+    auto decisionStart = std::chrono::high_resolution_clock::now();
 
     SetGlobalDebugInterface(debugInterface);
 
     int actionDuration = (int)lround(Emulator::GetGlobalConstants()->ticksPerSecond) / 2;
     int nActions = 5;
-    int nStrategies = 100;
-    int nMutations = 5;
-
-    Emulator::TWorld world = Emulator::TWorld::FormApi(game);
+    int nStrategies = 100 * pool.Size();
+    // uniform random strategies keep exploring outside of the planner's distribution, a tree search over discrete
+    // actions gets a few iterations per worker and the rest is sampled from the cross-entropy planner
+    int nRandomStrategies = Emulator::BATCH_SIZE * pool.Size();
+    int generationSize = 2 * Emulator::BATCH_SIZE * pool.Size();
+    int nElites = generationSize / 8;
+    int nMctsIterations = 2 * Emulator::BATCH_SIZE;
+    // mutations of the best strategy share their first actions with it, so they are emulated through prefix caches
+    int nMutations = Emulator::BATCH_SIZE * pool.Size();
+
+    Emulator::TWorld world = tickWorld;
     memory.Update(world);
-    for (const auto& sound: game.sounds) {
-        memory.UpdateSoundKnowledge(world, Emulator::TSound::FromApi(sound));
+    for (const auto& sound: sounds) {
+        memory.UpdateSoundKnowledge(world, sound);
     }
 
     memory.InjectKnowledge(world);
+    world.UpdateThreats();
     world.UpdateLootIndex();
     world.UpdateUnitsTargetLoot();
 
     {
-        auto& newState = world.StateByUnitId[unit.id];
+        auto& newState = world.StateByUnitId[unit.Id];
         newState.Sync(world);
     }
 
+    // teammates follow their latest best strategies in the rollouts, so every decision optimizes the unit against
+    // the rest of the team's plan: coordinate descent over the units, one unit per decision
+    world.TeammateStrategies.clear();
+    for (const auto& [teammateId, strategies]: forcedStrategiesById) {
+        if (teammateId == unit.Id || strategies.empty()) {
+            continue;
+        }
+        const auto* teammate = world.Units.Find(teammateId);
+        if (teammate && teammate->PlayerId == world.MyId) {
+            world.TeammateStrategies.emplace_back(teammateId, strategies.front());
+        }
+    }
+    std::sort(world.TeammateStrategies.begin(), world.TeammateStrategies.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
     std::optional<Emulator::TScore> bestScore = std::nullopt;
     std::optional<Emulator::TStrategy> bestStrategy;
 
-    std::vector<int> projectileIds;
-    for (const auto& [projectileId, _]: world.ProjectileById) {
-        projectileIds.push_back(projectileId);
-    }
-
-    for (const auto& [_, projectile]: world.ProjectileById) {
-        if (!SegmentIntersectsCircle(projectile.Position, projectile.Position + projectile.Velocity * projectile.LifeTime, Emulator::Vector2D::FromApi(unit.position), constants->unitRadius)) {
+    for (const auto& projectile: world.Projectiles) {
+        if (!SegmentIntersectsCircle(projectile.Position, projectile.Position + projectile.Velocity * projectile.LifeTime, unit.Position, constants->unitRadius)) {
             continue;
         }
         auto direction = Emulator::rot90(projectile.Velocity);
@@ -93,44 +161,95 @@ model::UnitOrder MyStrategy::getUnitOrder(const model::Game& game, DebugInterfac
     }
 
     forcedStrategies.push_back(Emulator::TStrategy{
-        .GoTo = Emulator::GetTarget(world, unit.id, false),
+        .GoTo = Emulator::GetTarget(world, unit.Id, false),
     });
 
     forcedStrategies.push_back(Emulator::TStrategy{
-        .GoTo = Emulator::GetTarget(world, unit.id, true),
+        .GoTo = Emulator::GetTarget(world, unit.Id, true),
     });
 
+    auto deadline = scheduler.GetDeadline(unit.Id, decisionStart);
+    // rollouts still running at the end of the tick are dropped, whatever phase they belong to
+    auto hardDeadline = scheduler.GetHardDeadline();
+
+    pool.SetWorld(world, rand());
+    auto result = pool.Evaluate({
+        .UnitId = unit.Id,
+        .UntilTick = world.CurrentTick + nActions * actionDuration,
+        .ForcedStrategies = &forcedStrategies,
+        .RandomStrategies = nRandomStrategies,
+        .ActionDuration = actionDuration,
+        .NActions = nActions,
+        .Deadline = deadline,
+        .HardDeadline = hardDeadline,
+    });
 
-    static int64_t globalTimeResource = 0;
-    int64_t microsecondsToGo = 30000 / constants->teamSize;
-    globalTimeResource += microsecondsToGo;
+    bool keptPlan = false;
+    if (result.Best) {
+        bestScore = result.Best->Score;
+        bestStrategy = std::move(result.Best->Strategy);
+        keptPlan = hadPlan && result.Best->CandidateIndex == 0;
+    }
 
-    auto start = std::chrono::high_resolution_clock::now();
+    auto mctsResult = mctsPlanner.Search(pool, {
+        .UnitId = unit.Id,
+        .UntilTick = world.CurrentTick + nActions * actionDuration,
+        .ActionDuration = actionDuration,
+        .Iterations = nMctsIterations,
+        .Deadline = deadline,
+        .HardDeadline = hardDeadline,
+    });
+    result.RandomEvaluated += mctsResult.Iterations;
+    if (mctsResult.Best && (!bestScore || mctsResult.Best->Score < *bestScore)) {
+        bestScore = mctsResult.Best->Score;
+        bestStrategy = std::move(mctsResult.Best->Strategy);
+        keptPlan = false;
+    }
 
-    for (int i = 0;; ++i) {
-        if (i >= nStrategies + forcedStrategies.size()) {
-            std::cerr << i << "\t" << forcedStrategies.size() << "\n";
+    planner.Shift(world.CurrentTick, actionDuration, nActions);
+    auto sample = [&](std::mt19937& random) {
+        return planner.Sample(random);
+    };
+    for (int sampled = nRandomStrategies + mctsResult.Iterations + nMutations; sampled < nStrategies; ) {
+        auto generation = pool.EvaluateSampled(std::min(generationSize, nStrategies - sampled), sample, unit.Id,
+                                               world.CurrentTick + nActions * actionDuration, deadline, hardDeadline);
+        if (generation.empty()) {
             break;
         }
+        sampled += static_cast<int>(generation.size());
+        result.RandomEvaluated += static_cast<int>(generation.size());
 
-        if (i > forcedStrategies.size() && std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now()-start).count() > globalTimeResource) {
-            std::cerr << i << "\t" << forcedStrategies.size() << "\n";
-            break;
+        if (!bestScore || generation[0].Score < *bestScore) {
+            bestScore = generation[0].Score;
+            bestStrategy = generation[0].Strategy;
+            keptPlan = false;
         }
 
-        Emulator::TStrategy strategy;
-
-        if (i < forcedStrategies.size()) {
-            strategy = forcedStrategies[i];
-        } else {
-            strategy = Emulator::GenerateRandomStrategy(world.CurrentTick, actionDuration, nActions);
+        std::vector<const Emulator::TStrategy*> elites;
+        for (int i = 0; i < std::min(nElites, static_cast<int>(generation.size())); ++i) {
+            elites.push_back(&generation[i].Strategy);
         }
-        auto score = Emulator::EvaluateStrategy(strategy, world, unit.id, world.CurrentTick + nActions * actionDuration);
-//        Emulator::VisualiseStrategy(strategy, world, unit.id, world.CurrentTick + nActions * actionDuration);
+        planner.Refit(elites);
+    }
 
-        if (!bestScore || score < *bestScore) {
-            bestScore = score;
-            bestStrategy = std::move(strategy);
+    if (bestScore && !bestStrategy->GoTo && std::chrono::high_resolution_clock::now() < deadline) {
+        std::mt19937 random(rand());
+        std::vector<Emulator::TStrategy> mutations;
+        mutations.reserve(nMutations);
+        for (int i = 0; i < nMutations; ++i) {
+            mutations.push_back(bestStrategy->Mutate(random));
+        }
+        auto scores = pool.EvaluateCached(mutations, unit.Id, world.CurrentTick + nActions * actionDuration, deadline, hardDeadline);
+        for (int i = 0; i < nMutations; ++i) {
+            if (!scores[i]) {
+                continue;
+            }
+            ++result.RandomEvaluated;
+            if (*scores[i] < *bestScore) {
+                bestScore = scores[i];
+                bestStrategy = std::move(mutations[i]);
+                keptPlan = false;
+            }
         }
     }
 
@@ -144,17 +263,17 @@ model::UnitOrder MyStrategy::getUnitOrder(const model::Game& game, DebugInterfac
 //
 //    Emulator::VisualiseStrategy(bestStrategy, world, unit.id, world.CurrentTick + nActions * actionDuration);
 //    debugInterface->addPlacedText(unit.position, std::to_string(std::get<0>(*bestScore)), model::Vec2{1, 0}, 2, debugging::Color{0, 0, 0, 1});
-//    for (const auto& [_, unitToDraw]: world.UnitById) {
+//    for (const auto& unitToDraw: world.Units) {
 //        debugInterface->addCircle(unitToDraw.Position.ToApi(), 0.6, debugging::Color(0, 1, 1, 1));
 //    }
 //    debugInterface->addCircle(GetTarget(world, unit.id).ToApi(), 0.25, debugging::Color(1, 0, 1, 1));
-//    for (const auto& [_, loot]: world.LootById) {
+//    for (const auto& loot: world.Loot) {
 //        debugInterface->addCircle(loot.Position.ToApi(), 0.6, debugging::Color(1, 0, 1, 1));
 //    }
 //
-//    for (const auto& [_, otherUnit]: world.UnitById) {
+//    for (const auto& otherUnit: world.Units) {
 //        auto color = debugging::Color(0, 1, 0, 1);
-//        if (Emulator::GetGlobalConstants()->obstaclesMeta.SegmentIntersectsObstacle(otherUnit.Position, Emulator::Vector2D::FromApi(unit.position))) {
+//        if (Emulator::GetGlobalConstants()->obstaclesMeta.SegmentIntersectsObstacle(otherUnit.Position, unit.Position)) {
 //            color = debugging::Color(1, 0, 0, 1);
 //        }
 //        debugInterface->addPolyLine({unit.position, otherUnit.Position.ToApi()}, 0.1, color);
@@ -162,15 +281,26 @@ model::UnitOrder MyStrategy::getUnitOrder(const model::Game& game, DebugInterfac
 
 //    debugInterface->addCircle(unit.position, 0.9, world.PreprocessedDataById[unit.id].InDanger ? debugging::Color(1, 0, 0, 1):debugging::Color(0, 1, 0, 1));
 
-    assert(bestStrategy);
-    assert(bestScore);
+    // nothing finished before the hard deadline: keep following the carried plan, or the first forced strategy
+    if (!bestStrategy) {
+        bestStrategy = forcedStrategies.front();
+        keptPlan = hadPlan;
+    }
 
 
     // TODO: test this
-    if (bestScore->HealthScore > (constants->unitHealth - unit.health) * nActions * actionDuration + 1e-6) {
-        for (auto strategy: forcedStrategies) {
+    if (bestScore && bestScore->HealthScore > (constants->unitHealth - unit.Health) * nActions * actionDuration + 1e-6) {
+        auto softStrategies = forcedStrategies;
+        for (auto& strategy: softStrategies) {
             strategy.ObedienceLevel = Emulator::VERY_SOFT;
-            auto score = Emulator::EvaluateStrategy(strategy, world, unit.id, world.CurrentTick + nActions * actionDuration);
+        }
+        auto scores = pool.EvaluateAll(softStrategies, unit.Id, world.CurrentTick + nActions * actionDuration, hardDeadline);
+
+        for (size_t i = 0; i < softStrategies.size(); ++i) {
+            if (!scores[i]) {
+                continue;
+            }
+            const auto& score = *scores[i];
 
             if (score.HealthScore >= bestScore->HealthScore - 1e-6) {
                 continue;
@@ -178,12 +308,13 @@ model::UnitOrder MyStrategy::getUnitOrder(const model::Game& game, DebugInterfac
 
             if (score < *bestScore) {
                 bestScore = score;
-                bestStrategy = std::move(strategy);
+                bestStrategy = std::move(softStrategies[i]);
+                keptPlan = false;
             }
         }
     }
 
-//    if (bestScore->HealthScore > (constants->unitHealth - unit.health) * nActions * actionDuration + 1e-6) {
+//    if (bestScore->HealthScore > (constants->unitHealth - unit.Health) * nActions * actionDuration + 1e-6) {
 ////        debugInterface->addCircle(unit.position, 0.9, debugging::Color(1, 0, 0, 1));
 //        for (auto strategy: forcedStrategies) {
 //            strategy.ObedienceLevel = Emulator::SOFT;
@@ -200,7 +331,7 @@ model::UnitOrder MyStrategy::getUnitOrder(const model::Game& game, DebugInterfac
 //        }
 //    }
 
-//    if (bestScore->HealthScore > (constants->unitHealth - unit.health) * nActions * actionDuration + 1e-6) {
+//    if (bestScore->HealthScore > (constants->unitHealth - unit.Health) * nActions * actionDuration + 1e-6) {
 ////        debugInterface->addCircle(unit.position, 0.9, debugging::Color(1, 1, 0, 1));
 //        for (auto strategy: forcedStrategies) {
 //            strategy.ObedienceLevel = Emulator::HARD;
@@ -217,29 +348,44 @@ model::UnitOrder MyStrategy::getUnitOrder(const model::Game& game, DebugInterfac
 //        }
 //    }
 
-    auto order = bestStrategy->GetOrder(world, unit.id, /*forSimulation*/ false);
+    auto order = bestStrategy->GetOrder(world, unit.Id, /*forSimulation*/ false);
+    // the tree keeps the branch of what the unit does, not its own favourite
+    mctsPlanner.SetExecuted({
+        .Tick = world.CurrentTick,
+        .Speed = bestStrategy->GetAction(world, unit.Id, world.CurrentTick).Speed,
+    });
 
     {
-        auto newState = world.StateByUnitId[unit.id];
+        auto newState = world.StateByUnitId[unit.Id];
         newState.Update(world, order);
-        memory.RememberState(unit.id, newState);
+        memory.RememberState(unit.Id, newState);
     }
 
-    if (order.Pickup && unit.aim < 1e-4) {
+    if (order.Pickup && unit.Aim < 1e-4) {
         memory.ForgetLoot(order.LootId);
     }
 
     forcedStrategies.resize(0);
     forcedStrategies.push_back(*bestStrategy);
-    for (int i = 0; i < nMutations; ++i) {
-        forcedStrategies.push_back(bestStrategy->Mutate());
-    }
 
-    globalTimeResource -= std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now()-start).count();
+    auto finish = std::chrono::high_resolution_clock::now();
+    auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(finish - decisionStart).count();
+    scheduler.EndDecision(unit.Id, microseconds, !keptPlan);
+
+    Emulator::GetGlobalTelemetry().AddUnitDecision({
+        .Tick = world.CurrentTick,
+        .UnitId = unit.Id,
+        .Microseconds = microseconds,
+        .ForcedEvaluated = result.ForcedEvaluated,
+        .RandomEvaluated = result.RandomEvaluated,
+        .TimeResource = scheduler.GetReserve(),
+    });
 
     return order.ToApi();
 }
 
 void MyStrategy::debugUpdate(DebugInterface& debugInterface) {}
 
-void MyStrategy::finish() {}
\ No newline at end of file
+void MyStrategy::finish() {
+    Emulator::GetGlobalTelemetry().PrintSummary(std::cerr);
+}
\ No newline at end of file
@@ -6,13 +6,16 @@
 #include "model/Order.hpp"
 #include "model/Constants.hpp"
 #include "emulator/public.h"
+#include <vector>
 
 class MyStrategy {
 public:
     MyStrategy(const model::Constants& constants);
     static model::Order getOrder(const model::Game& game, DebugInterface* debugInterface);
-    static model::Order doGetOrder(const model::Game& game, DebugInterface* debugInterface);
-    static model::UnitOrder getUnitOrder(const model::Game& game, DebugInterface* debugInterface, const model::Unit& unit);
+    // Same as above for a world decoded with Emulator::TWorld::ReadApi
+    static model::Order getOrder(const Emulator::TWorld& world, const std::vector<Emulator::TSound>& sounds, DebugInterface* debugInterface);
+    static model::Order doGetOrder(const Emulator::TWorld& world, const std::vector<Emulator::TSound>& sounds, DebugInterface* debugInterface);
+    static model::UnitOrder getUnitOrder(const Emulator::TWorld& tickWorld, const std::vector<Emulator::TSound>& sounds, DebugInterface* debugInterface, const Emulator::TUnit& unit);
     void debugUpdate(DebugInterface& debugInterface);
     void finish();
 };
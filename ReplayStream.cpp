@@ -0,0 +1,90 @@
+#include "ReplayStream.hpp"
+#include <stdexcept>
+
+const std::string REPLAY_MAGIC = "AICUP22REPLAY";
+const int REPLAY_VERSION = 1;
+
+void writeReplayHeader(OutputStream& stream)
+{
+    stream.write(REPLAY_MAGIC);
+    stream.write(REPLAY_VERSION);
+}
+
+void readReplayHeader(InputStream& stream)
+{
+    if (stream.readString() != REPLAY_MAGIC) {
+        throw std::runtime_error("Not a replay file");
+    }
+    if (stream.readInt() != REPLAY_VERSION) {
+        throw std::runtime_error("Unsupported replay version");
+    }
+}
+
+FileInputStream::FileInputStream(const std::string& path)
+    : file(std::fopen(path.c_str(), "rb"))
+{
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+}
+
+FileInputStream::~FileInputStream()
+{
+    std::fclose(file);
+}
+
+void FileInputStream::readBytes(char* buffer, size_t byteCount)
+{
+    if (std::fread(buffer, 1, byteCount, file) != byteCount) {
+        throw std::runtime_error("Unexpected end of file");
+    }
+}
+
+bool FileInputStream::atEnd()
+{
+    int c = std::fgetc(file);
+    if (c == EOF) {
+        return true;
+    }
+    std::ungetc(c, file);
+    return false;
+}
+
+FileOutputStream::FileOutputStream(const std::string& path)
+    : file(std::fopen(path.c_str(), "wb"))
+{
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+}
+
+FileOutputStream::~FileOutputStream()
+{
+    std::fclose(file);
+}
+
+void FileOutputStream::writeBytes(const char* buffer, size_t byteCount)
+{
+    if (std::fwrite(buffer, 1, byteCount, file) != byteCount) {
+        throw std::runtime_error("Failed to write to file");
+    }
+}
+
+void FileOutputStream::flush()
+{
+    if (std::fflush(file) != 0) {
+        throw std::runtime_error("Failed to flush file");
+    }
+}
+
+TeeInputStream::TeeInputStream(InputStream& source, OutputStream& sink)
+    : source(source)
+    , sink(sink)
+{
+}
+
+void TeeInputStream::readBytes(char* buffer, size_t byteCount)
+{
+    source.readBytes(buffer, byteCount);
+    sink.writeBytes(buffer, byteCount);
+}
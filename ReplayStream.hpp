@@ -0,0 +1,56 @@
+#ifndef __REPLAY_STREAM_HPP__
+#define __REPLAY_STREAM_HPP__
+
+#include "Stream.hpp"
+
+#include <cstdio>
+#include <string>
+
+// A replay file starts with REPLAY_MAGIC and REPLAY_VERSION,
+// followed by the server messages exactly as they came from the socket
+extern const std::string REPLAY_MAGIC;
+extern const int REPLAY_VERSION;
+
+void writeReplayHeader(OutputStream& stream);
+// Throws if the stream is not a replay of a supported version
+void readReplayHeader(InputStream& stream);
+
+class FileInputStream : public InputStream {
+public:
+    FileInputStream(const std::string& path);
+    ~FileInputStream();
+    FileInputStream(const FileInputStream&) = delete;
+    FileInputStream& operator=(const FileInputStream&) = delete;
+    void readBytes(char* buffer, size_t byteCount);
+    // Check if there is nothing left to read
+    bool atEnd();
+
+private:
+    FILE* file;
+};
+
+class FileOutputStream : public OutputStream {
+public:
+    FileOutputStream(const std::string& path);
+    ~FileOutputStream();
+    FileOutputStream(const FileOutputStream&) = delete;
+    FileOutputStream& operator=(const FileOutputStream&) = delete;
+    void writeBytes(const char* buffer, size_t byteCount);
+    void flush();
+
+private:
+    FILE* file;
+};
+
+// Reads from source and copies everything read into sink
+class TeeInputStream : public InputStream {
+public:
+    TeeInputStream(InputStream& source, OutputStream& sink);
+    void readBytes(char* buffer, size_t byteCount);
+
+private:
+    InputStream& source;
+    OutputStream& sink;
+};
+
+#endif
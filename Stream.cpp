@@ -1,20 +1,15 @@
 #include "Stream.hpp"
-#include <algorithm>
-#include <cstring>
 #include <vector>
 
-// Check if current machine is little endian
-bool isLittleEndianMachine()
+std::span<const char> InputStream::readSpan(size_t byteCount)
 {
-    union {
-        unsigned short value;
-        char bytes[2];
-    } test = { 0x0201 };
-    return test.bytes[0] == 1;
+    if (spanBuffer.size() < byteCount) {
+        spanBuffer.resize(byteCount);
+    }
+    readBytes(spanBuffer.data(), byteCount);
+    return std::span<const char>(spanBuffer.data(), byteCount);
 }
 
-bool IS_LITTLE_ENDIAN_MACHINE = isLittleEndianMachine();
-
 // Read a bool from this stream
 bool InputStream::readBool()
 {
@@ -28,10 +23,7 @@ int InputStream::readInt()
 {
     char buffer[sizeof(int)];
     readBytes(buffer, sizeof(int));
-    if (!IS_LITTLE_ENDIAN_MACHINE) {
-        std::reverse(buffer, buffer + sizeof(int));
-    }
-    return *reinterpret_cast<int*>(buffer);
+    return decodeLittleEndian<int>(buffer);
 }
 
 // Read a long long from this stream
@@ -39,10 +31,7 @@ long long InputStream::readLongLong()
 {
     char buffer[sizeof(long long)];
     readBytes(buffer, sizeof(long long));
-    if (!IS_LITTLE_ENDIAN_MACHINE) {
-        std::reverse(buffer, buffer + sizeof(long long));
-    }
-    return *reinterpret_cast<long long*>(buffer);
+    return decodeLittleEndian<long long>(buffer);
 }
 
 // Read a float from this stream
@@ -50,10 +39,7 @@ float InputStream::readFloat()
 {
     char buffer[sizeof(float)];
     readBytes(buffer, sizeof(float));
-    if (!IS_LITTLE_ENDIAN_MACHINE) {
-        std::reverse(buffer, buffer + sizeof(float));
-    }
-    return *reinterpret_cast<float*>(buffer);
+    return decodeLittleEndian<float>(buffer);
 }
 
 // Read a double from this stream
@@ -61,10 +47,7 @@ double InputStream::readDouble()
 {
     char buffer[sizeof(double)];
     readBytes(buffer, sizeof(double));
-    if (!IS_LITTLE_ENDIAN_MACHINE) {
-        std::reverse(buffer, buffer + sizeof(double));
-    }
-    return *reinterpret_cast<double*>(buffer);
+    return decodeLittleEndian<double>(buffer);
 }
 
 // Read a string from this stream
@@ -75,6 +58,28 @@ std::string InputStream::readString()
     return std::string(&buffer[0], buffer.size());
 }
 
+// Read count ints from this stream with a single readBytes
+void InputStream::readInts(int* values, size_t count)
+{
+    readBytes(reinterpret_cast<char*>(values), count * sizeof(int));
+    if constexpr (std::endian::native != std::endian::little) {
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = decodeLittleEndian<int>(reinterpret_cast<const char*>(values + i));
+        }
+    }
+}
+
+// Read count doubles from this stream with a single readBytes
+void InputStream::readDoubles(double* values, size_t count)
+{
+    readBytes(reinterpret_cast<char*>(values), count * sizeof(double));
+    if constexpr (std::endian::native != std::endian::little) {
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = decodeLittleEndian<double>(reinterpret_cast<const char*>(values + i));
+        }
+    }
+}
+
 // Write a bool into this stream
 void OutputStream::write(bool value)
 {
@@ -87,10 +92,7 @@ void OutputStream::write(bool value)
 void OutputStream::write(int value)
 {
     char buffer[sizeof(int)];
-    std::memcpy(buffer, &value, sizeof(int));
-    if (!IS_LITTLE_ENDIAN_MACHINE) {
-        std::reverse(buffer, buffer + sizeof(int));
-    }
+    encodeLittleEndian(value, buffer);
     writeBytes(buffer, sizeof(int));
 }
 
@@ -98,10 +100,7 @@ void OutputStream::write(int value)
 void OutputStream::write(long long value)
 {
     char buffer[sizeof(long long)];
-    std::memcpy(buffer, &value, sizeof(long long));
-    if (!IS_LITTLE_ENDIAN_MACHINE) {
-        std::reverse(buffer, buffer + sizeof(long long));
-    }
+    encodeLittleEndian(value, buffer);
     writeBytes(buffer, sizeof(long long));
 }
 
@@ -109,10 +108,7 @@ void OutputStream::write(long long value)
 void OutputStream::write(float value)
 {
     char buffer[sizeof(float)];
-    std::memcpy(buffer, &value, sizeof(float));
-    if (!IS_LITTLE_ENDIAN_MACHINE) {
-        std::reverse(buffer, buffer + sizeof(float));
-    }
+    encodeLittleEndian(value, buffer);
     writeBytes(buffer, sizeof(float));
 }
 
@@ -120,10 +116,7 @@ void OutputStream::write(float value)
 void OutputStream::write(double value)
 {
     char buffer[sizeof(double)];
-    std::memcpy(buffer, &value, sizeof(double));
-    if (!IS_LITTLE_ENDIAN_MACHINE) {
-        std::reverse(buffer, buffer + sizeof(double));
-    }
+    encodeLittleEndian(value, buffer);
     writeBytes(buffer, sizeof(double));
 }
 
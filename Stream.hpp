@@ -1,13 +1,46 @@
 #ifndef __STREAM_HPP__
 #define __STREAM_HPP__
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <span>
 #include <string>
+#include <vector>
+
+// Decode a little endian value, the byte swap is compiled out on little endian machines
+template <typename T>
+inline T decodeLittleEndian(const char* bytes)
+{
+    T value;
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(&value, bytes, sizeof(T));
+    } else {
+        char reversed[sizeof(T)];
+        std::reverse_copy(bytes, bytes + sizeof(T), reversed);
+        std::memcpy(&value, reversed, sizeof(T));
+    }
+    return value;
+}
+
+// Encode a value as little endian
+template <typename T>
+inline void encodeLittleEndian(T value, char* bytes)
+{
+    std::memcpy(bytes, &value, sizeof(T));
+    if constexpr (std::endian::native != std::endian::little) {
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+}
 
 // Input stream interface
 class InputStream {
 public:
     // Read exactly byteCount bytes into buffer
     virtual void readBytes(char* buffer, size_t byteCount) = 0;
+    // Read exactly byteCount bytes and return them in place, valid until the next read from this stream.
+    // Buffered streams return their own buffer, the default copies with readBytes.
+    virtual std::span<const char> readSpan(size_t byteCount);
     // Read a bool from this stream
     bool readBool();
     // Read an int from this stream
@@ -20,6 +53,37 @@ public:
     double readDouble();
     // Read a string from this stream
     std::string readString();
+    // Read count ints from this stream with a single readBytes
+    void readInts(int* values, size_t count);
+    // Read count doubles from this stream with a single readBytes
+    void readDoubles(double* values, size_t count);
+
+private:
+    std::vector<char> spanBuffer;
+};
+
+// Decodes fields from bytes already read from a stream. Fixed-size parts of a message
+// are read with one readBytes and then taken apart here without further virtual calls.
+class ByteReader {
+public:
+    explicit ByteReader(const char* bytes) : bytes(bytes) { }
+    // Read a bool from the bytes
+    bool readBool() { return *bytes++ != 0; }
+    // Read an int from the bytes
+    int readInt() { return read<int>(); }
+    // Read a double from the bytes
+    double readDouble() { return read<double>(); }
+
+private:
+    template <typename T>
+    T read()
+    {
+        T value = decodeLittleEndian<T>(bytes);
+        bytes += sizeof(T);
+        return value;
+    }
+
+    const char* bytes;
 };
 
 // Output stream interface
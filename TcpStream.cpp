@@ -1,11 +1,13 @@
 #include "TcpStream.hpp"
+#include <algorithm>
 #include <cstring>
 #include <stdexcept>
 
 TcpStream::TcpStream(const std::string& host, int port)
-    : readBufferPos(0)
+    : readBuffer(BUFFER_CAPACITY)
+    , readBufferPos(0)
     , readBufferSize(0)
-    , writeBufferPos(0)
+    , writeBuffer(BUFFER_CAPACITY)
     , writeBufferSize(0)
 {
 #ifdef _WIN32
@@ -39,32 +41,88 @@ TcpStream::TcpStream(const std::string& host, int port)
 
 void TcpStream::readBytes(char* buffer, size_t byteCount)
 {
-    while (byteCount > 0) {
-        if (readBufferSize > 0) {
-            if (readBufferSize >= byteCount) {
-                memcpy(buffer, this->readBuffer + readBufferPos, byteCount);
-                readBufferPos += byteCount;
-                readBufferSize -= byteCount;
-                return;
-            }
-            memcpy(buffer, this->readBuffer + readBufferPos, readBufferSize);
-            buffer += readBufferSize;
-            byteCount -= readBufferSize;
-            readBufferPos += readBufferSize;
-            readBufferSize = 0;
+    size_t buffered = std::min(byteCount, readBufferSize);
+    memcpy(buffer, readBuffer.data() + readBufferPos, buffered);
+    readBufferPos += buffered;
+    readBufferSize -= buffered;
+    buffer += buffered;
+    byteCount -= buffered;
+    if (byteCount == 0) {
+        return;
+    }
+    if (byteCount >= DIRECT_IO_THRESHOLD) {
+        while (byteCount > 0) {
+            size_t received = receive(buffer, byteCount);
+            buffer += received;
+            byteCount -= received;
         }
-        if (readBufferPos == BUFFER_CAPACITY) {
+        return;
+    }
+    fillReadBuffer(byteCount);
+    memcpy(buffer, readBuffer.data() + readBufferPos, byteCount);
+    readBufferPos += byteCount;
+    readBufferSize -= byteCount;
+}
+
+std::span<const char> TcpStream::readSpan(size_t byteCount)
+{
+    fillReadBuffer(byteCount);
+    std::span<const char> result(readBuffer.data() + readBufferPos, byteCount);
+    readBufferPos += byteCount;
+    readBufferSize -= byteCount;
+    return result;
+}
+
+void TcpStream::fillReadBuffer(size_t byteCount)
+{
+    while (readBufferSize < byteCount) {
+        size_t tailCapacity = readBuffer.size() - readBufferPos - readBufferSize;
+        // keep the read ahead large: move unread bytes to the front, grow if that is not enough
+        if (tailCapacity < std::max(byteCount - readBufferSize, BUFFER_CAPACITY / 4)) {
+            memmove(readBuffer.data(), readBuffer.data() + readBufferPos, readBufferSize);
             readBufferPos = 0;
+            size_t required = std::max(byteCount, readBufferSize + BUFFER_CAPACITY / 4);
+            if (readBuffer.size() < required) {
+                readBuffer.resize(std::max(required, 2 * readBuffer.size()));
+            }
         }
-        RECV_SEND_T received = recv(sock, this->readBuffer + readBufferPos + readBufferSize,
-            BUFFER_CAPACITY - readBufferPos - readBufferSize, 0);
-        if (received < 0) {
-            throw std::runtime_error("Failed to read from socket");
-        }
-        readBufferSize += received;
+        receive(nullptr, 0);
     }
 }
 
+size_t TcpStream::receive(char* buffer, size_t byteCount)
+{
+    if (readBufferSize == 0) {
+        readBufferPos = 0;
+    }
+    char* tail = readBuffer.data() + readBufferPos + readBufferSize;
+    size_t tailCapacity = readBuffer.size() - readBufferPos - readBufferSize;
+#ifdef _WIN32
+    RECV_SEND_T received = byteCount > 0
+        ? recv(sock, buffer, static_cast<int>(byteCount), 0)
+        : recv(sock, tail, static_cast<int>(tailCapacity), 0);
+#else
+    iovec parts[2];
+    int partCount = 0;
+    if (byteCount > 0) {
+        parts[partCount++] = { buffer, byteCount };
+    }
+    if (tailCapacity > 0) {
+        parts[partCount++] = { tail, tailCapacity };
+    }
+    RECV_SEND_T received = readv(sock, parts, partCount);
+#endif
+    if (received < 0) {
+        throw std::runtime_error("Failed to read from socket");
+    }
+    if (received == 0) {
+        throw std::runtime_error("Connection closed");
+    }
+    size_t direct = std::min(static_cast<size_t>(received), byteCount);
+    readBufferSize += received - direct;
+    return direct;
+}
+
 TcpStream::~TcpStream()
 {
 #ifdef _WIN32
@@ -79,30 +137,53 @@ TcpStream::~TcpStream()
 
 void TcpStream::writeBytes(const char* buffer, size_t byteCount)
 {
-    while (byteCount > 0) {
-        size_t capacity = BUFFER_CAPACITY - writeBufferPos - writeBufferSize;
-        if (capacity >= byteCount) {
-            memcpy(this->writeBuffer + writeBufferPos + writeBufferSize, buffer, byteCount);
-            writeBufferSize += byteCount;
-            return;
-        }
-        memcpy(this->writeBuffer + writeBufferPos + writeBufferSize, buffer, capacity);
-        writeBufferSize += capacity;
-        byteCount -= capacity;
-        buffer += capacity;
-        flush();
+    if (writeBufferSize + byteCount <= writeBuffer.size()) {
+        memcpy(writeBuffer.data() + writeBufferSize, buffer, byteCount);
+        writeBufferSize += byteCount;
+        return;
     }
+    if (byteCount >= DIRECT_IO_THRESHOLD) {
+        sendAll(writeBuffer.data(), writeBufferSize, buffer, byteCount);
+        writeBufferSize = 0;
+        return;
+    }
+    flush();
+    memcpy(writeBuffer.data(), buffer, byteCount);
+    writeBufferSize = byteCount;
 }
 
 void TcpStream::flush()
 {
-    while (writeBufferSize > 0) {
-        RECV_SEND_T sent = send(sock, writeBuffer + writeBufferPos, writeBufferSize, 0);
+    sendAll(writeBuffer.data(), writeBufferSize, nullptr, 0);
+    writeBufferSize = 0;
+}
+
+// Both parts go out with a single writev where the platform has it
+void TcpStream::sendAll(const char* first, size_t firstCount, const char* second, size_t secondCount)
+{
+    while (firstCount + secondCount > 0) {
+#ifdef _WIN32
+        RECV_SEND_T sent = firstCount > 0
+            ? send(sock, first, static_cast<int>(firstCount), 0)
+            : send(sock, second, static_cast<int>(secondCount), 0);
+#else
+        iovec parts[2];
+        int partCount = 0;
+        if (firstCount > 0) {
+            parts[partCount++] = { const_cast<char*>(first), firstCount };
+        }
+        if (secondCount > 0) {
+            parts[partCount++] = { const_cast<char*>(second), secondCount };
+        }
+        RECV_SEND_T sent = writev(sock, parts, partCount);
+#endif
         if (sent < 0) {
             throw std::runtime_error("Failed to write to socket");
         }
-        writeBufferPos += sent;
-        writeBufferSize -= sent;
+        size_t fromFirst = std::min(static_cast<size_t>(sent), firstCount);
+        first += fromFirst;
+        firstCount -= fromFirst;
+        second += sent - fromFirst;
+        secondCount -= sent - fromFirst;
     }
-    writeBufferPos = 0;
-}
\ No newline at end of file
+}
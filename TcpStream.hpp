@@ -2,6 +2,8 @@
 #define __TCP_STREAM_HPP__
 
 #include "Stream.hpp"
+#include <span>
+#include <vector>
 
 #ifdef _WIN32
 #ifndef _WIN32_WINNT
@@ -15,27 +17,40 @@ typedef int RECV_SEND_T;
 #include <netdb.h>
 #include <netinet/tcp.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 typedef int SOCKET;
 typedef ssize_t RECV_SEND_T;
 #endif
 
+// Buffered socket stream. The read buffer grows to fit the largest message it is asked for,
+// big reads and writes go straight between the socket and the caller with readv/writev.
 class TcpStream : public InputStream, public OutputStream {
 public:
     TcpStream(const std::string& host, int port);
     ~TcpStream();
     void readBytes(char* buffer, size_t byteCount);
+    // Consume the next byteCount bytes without copying them out,
+    // the span points into the read buffer and is valid until the next read
+    std::span<const char> readSpan(size_t byteCount);
     void writeBytes(const char* buffer, size_t byteCount);
     void flush();
 
 private:
+    // Make at least byteCount unread bytes contiguous in readBuffer
+    void fillReadBuffer(size_t byteCount);
+    // Receive into the caller's buffer first and read ahead into readBuffer with the rest
+    size_t receive(char* buffer, size_t byteCount);
+    void sendAll(const char* first, size_t firstCount, const char* second, size_t secondCount);
+
     SOCKET sock;
-    static const size_t BUFFER_CAPACITY = 8 * 1024;
-    char readBuffer[BUFFER_CAPACITY];
+    static const size_t BUFFER_CAPACITY = 64 * 1024;
+    // reads and writes at least this large skip the copy through the buffers
+    static const size_t DIRECT_IO_THRESHOLD = 16 * 1024;
+    std::vector<char> readBuffer;
     size_t readBufferPos;
     size_t readBufferSize;
-    char writeBuffer[BUFFER_CAPACITY];
-    size_t writeBufferPos;
+    std::vector<char> writeBuffer;
     size_t writeBufferSize;
 };
 
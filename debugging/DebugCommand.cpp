@@ -3,18 +3,18 @@
 
 namespace debugging {
 
-DebugCommand::Add::Add(std::shared_ptr<debugging::DebugData> debugData) : debugData(debugData) { }
+DebugCommand::Add::Add(debugging::DebugDataValue debugData) : debugData(std::move(debugData)) { }
 
 // Read Add from input stream
 DebugCommand::Add DebugCommand::Add::readFrom(InputStream& stream) {
-    std::shared_ptr<debugging::DebugData> debugData = debugging::DebugData::readFrom(stream);
+    debugging::DebugDataValue debugData = debugging::readDebugDataValue(stream);
     return DebugCommand::Add(debugData);
 }
 
 // Write Add to output stream
 void DebugCommand::Add::writeTo(OutputStream& stream) const {
     stream.write(TAG);
-    debugData->writeTo(stream);
+    debugging::writeDebugDataValue(stream, debugData);
 }
 
 // Get string representation of Add
@@ -22,7 +22,7 @@ std::string DebugCommand::Add::toString() const {
     std::stringstream ss;
     ss << "DebugCommand::Add { ";
     ss << "debugData: ";
-    ss << debugData->toString();
+    ss << debugging::debugDataValueToString(debugData);
     ss << " }";
     return ss.str();
 }
@@ -119,4 +119,30 @@ std::shared_ptr<DebugCommand> DebugCommand::readFrom(InputStream& stream) {
     }
 }
 
+// Read DebugCommandValue from input stream
+DebugCommandValue readDebugCommandValue(InputStream& stream) {
+    switch (stream.readInt()) {
+    case 0:
+        return DebugCommand::Add::readFrom(stream);
+    case 1:
+        return DebugCommand::Clear::readFrom(stream);
+    case 2:
+        return DebugCommand::SetAutoFlush::readFrom(stream);
+    case 3:
+        return DebugCommand::Flush::readFrom(stream);
+    default:
+        throw std::runtime_error("Unexpected tag value");
+    }
+}
+
+// Write DebugCommandValue to output stream
+void writeDebugCommandValue(OutputStream& stream, const DebugCommandValue& value) {
+    std::visit([&stream](const auto& alternative) { alternative.writeTo(stream); }, value);
+}
+
+// Get string representation of DebugCommandValue
+std::string debugCommandValueToString(const DebugCommandValue& value) {
+    return std::visit([](const auto& alternative) { return alternative.toString(); }, value);
+}
+
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <variant>
 #include <vector>
 
 namespace debugging {
@@ -42,9 +43,9 @@ public:
     static const int TAG = 0;
 
     // Data to add
-    std::shared_ptr<debugging::DebugData> debugData;
+    debugging::DebugDataValue debugData;
 
-    Add(std::shared_ptr<debugging::DebugData> debugData);
+    Add(debugging::DebugDataValue debugData);
 
     // Read Add from input stream
     static Add readFrom(InputStream& stream);
@@ -118,6 +119,18 @@ public:
     bool operator ==(const Flush& other) const;
 };
 
+// Debug command stored by value, alternatives follow the tag order
+using DebugCommandValue = std::variant<DebugCommand::Add, DebugCommand::Clear, DebugCommand::SetAutoFlush, DebugCommand::Flush>;
+
+// Read DebugCommandValue from input stream
+DebugCommandValue readDebugCommandValue(InputStream& stream);
+
+// Write DebugCommandValue to output stream
+void writeDebugCommandValue(OutputStream& stream, const DebugCommandValue& value);
+
+// Get string representation of DebugCommandValue
+std::string debugCommandValueToString(const DebugCommandValue& value);
+
 }
 
 #endif
\ No newline at end of file
@@ -587,4 +587,48 @@ std::shared_ptr<DebugData> DebugData::readFrom(InputStream& stream) {
     }
 }
 
+// Read DebugDataValue from input stream
+DebugDataValue readDebugDataValue(InputStream& stream) {
+    switch (stream.readInt()) {
+    case 0:
+        return DebugData::PlacedText::readFrom(stream);
+    case 1:
+        return DebugData::Circle::readFrom(stream);
+    case 2:
+        return DebugData::GradientCircle::readFrom(stream);
+    case 3:
+        return DebugData::Ring::readFrom(stream);
+    case 4:
+        return DebugData::Pie::readFrom(stream);
+    case 5:
+        return DebugData::Arc::readFrom(stream);
+    case 6:
+        return DebugData::Rect::readFrom(stream);
+    case 7:
+        return DebugData::Polygon::readFrom(stream);
+    case 8:
+        return DebugData::GradientPolygon::readFrom(stream);
+    case 9:
+        return DebugData::Segment::readFrom(stream);
+    case 10:
+        return DebugData::GradientSegment::readFrom(stream);
+    case 11:
+        return DebugData::PolyLine::readFrom(stream);
+    case 12:
+        return DebugData::GradientPolyLine::readFrom(stream);
+    default:
+        throw std::runtime_error("Unexpected tag value");
+    }
+}
+
+// Write DebugDataValue to output stream
+void writeDebugDataValue(OutputStream& stream, const DebugDataValue& value) {
+    std::visit([&stream](const auto& alternative) { alternative.writeTo(stream); }, value);
+}
+
+// Get string representation of DebugDataValue
+std::string debugDataValueToString(const DebugDataValue& value) {
+    return std::visit([](const auto& alternative) { return alternative.toString(); }, value);
+}
+
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <variant>
 #include <vector>
 
 namespace debugging {
@@ -381,6 +382,18 @@ public:
     std::string toString() const;
 };
 
+// Debug data stored by value, alternatives follow the tag order
+using DebugDataValue = std::variant<DebugData::PlacedText, DebugData::Circle, DebugData::GradientCircle, DebugData::Ring, DebugData::Pie, DebugData::Arc, DebugData::Rect, DebugData::Polygon, DebugData::GradientPolygon, DebugData::Segment, DebugData::GradientSegment, DebugData::PolyLine, DebugData::GradientPolyLine>;
+
+// Read DebugDataValue from input stream
+DebugDataValue readDebugDataValue(InputStream& stream);
+
+// Write DebugDataValue to output stream
+void writeDebugDataValue(OutputStream& stream, const DebugDataValue& value);
+
+// Get string representation of DebugDataValue
+std::string debugDataValueToString(const DebugDataValue& value);
+
 }
 
 #endif
\ No newline at end of file
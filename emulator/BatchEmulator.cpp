@@ -0,0 +1,466 @@
+#include "BatchEmulator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace Emulator {
+
+// The kernels below repeat the scalar TWorld code operation by operation, so every lane gets
+// bit-identical results to EvaluateStrategy. Keep it that way: no reordering, no FMA.
+
+#ifdef __AVX2__
+
+constexpr int PACK_WIDTH = 4;
+
+struct TPack {
+    __m256d Value;
+};
+
+struct TMask {
+    __m256d Value;
+};
+
+inline TPack Load(const double* from) { return {_mm256_load_pd(from)}; }
+inline void Store(double* to, TPack a) { _mm256_store_pd(to, a.Value); }
+inline TPack Broadcast(double x) { return {_mm256_set1_pd(x)}; }
+
+inline TPack operator+(TPack a, TPack b) { return {_mm256_add_pd(a.Value, b.Value)}; }
+inline TPack operator-(TPack a, TPack b) { return {_mm256_sub_pd(a.Value, b.Value)}; }
+inline TPack operator*(TPack a, TPack b) { return {_mm256_mul_pd(a.Value, b.Value)}; }
+inline TPack operator/(TPack a, TPack b) { return {_mm256_div_pd(a.Value, b.Value)}; }
+inline TPack Sqrt(TPack a) { return {_mm256_sqrt_pd(a.Value)}; }
+inline TPack Fabs(TPack a) { return {_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.Value)}; }
+
+inline TMask operator<(TPack a, TPack b) { return {_mm256_cmp_pd(a.Value, b.Value, _CMP_LT_OQ)}; }
+inline TMask operator<=(TPack a, TPack b) { return {_mm256_cmp_pd(a.Value, b.Value, _CMP_LE_OQ)}; }
+inline TMask operator>(TPack a, TPack b) { return {_mm256_cmp_pd(a.Value, b.Value, _CMP_GT_OQ)}; }
+inline TMask operator|(TMask a, TMask b) { return {_mm256_or_pd(a.Value, b.Value)}; }
+inline TMask operator&(TMask a, TMask b) { return {_mm256_and_pd(a.Value, b.Value)}; }
+inline TMask operator^(TMask a, TMask b) { return {_mm256_xor_pd(a.Value, b.Value)}; }
+
+inline TPack Select(TMask mask, TPack ifTrue, TPack ifFalse) { return {_mm256_blendv_pd(ifFalse.Value, ifTrue.Value, mask.Value)}; }
+inline uint32_t ToBits(TMask mask) { return static_cast<uint32_t>(_mm256_movemask_pd(mask.Value)); }
+
+#else
+
+constexpr int PACK_WIDTH = 1;
+
+struct TPack {
+    double Value;
+};
+
+struct TMask {
+    bool Value;
+};
+
+inline TPack Load(const double* from) { return {*from}; }
+inline void Store(double* to, TPack a) { *to = a.Value; }
+inline TPack Broadcast(double x) { return {x}; }
+
+inline TPack operator+(TPack a, TPack b) { return {a.Value + b.Value}; }
+inline TPack operator-(TPack a, TPack b) { return {a.Value - b.Value}; }
+inline TPack operator*(TPack a, TPack b) { return {a.Value * b.Value}; }
+inline TPack operator/(TPack a, TPack b) { return {a.Value / b.Value}; }
+inline TPack Sqrt(TPack a) { return {std::sqrt(a.Value)}; }
+inline TPack Fabs(TPack a) { return {std::fabs(a.Value)}; }
+
+inline TMask operator<(TPack a, TPack b) { return {a.Value < b.Value}; }
+inline TMask operator<=(TPack a, TPack b) { return {a.Value <= b.Value}; }
+inline TMask operator>(TPack a, TPack b) { return {a.Value > b.Value}; }
+inline TMask operator|(TMask a, TMask b) { return {a.Value || b.Value}; }
+inline TMask operator&(TMask a, TMask b) { return {a.Value && b.Value}; }
+inline TMask operator^(TMask a, TMask b) { return {a.Value != b.Value}; }
+
+inline TPack Select(TMask mask, TPack ifTrue, TPack ifFalse) { return mask.Value ? ifTrue : ifFalse; }
+inline uint32_t ToBits(TMask mask) { return mask.Value ? 1 : 0; }
+
+#endif
+
+static_assert(BATCH_SIZE % PACK_WIDTH == 0);
+static_assert(BATCH_SIZE <= 32);
+
+struct TLaneVectors {
+    alignas(32) double X[BATCH_SIZE];
+    alignas(32) double Y[BATCH_SIZE];
+};
+
+// TWorld::ClipVelocity, limitFactor is the aim slowdown of the planned unit (1 without a weapon)
+void ClipVelocities(TLaneVectors& velocity, const TLaneVectors& direction, const TConstants& constants, double limitFactor) {
+    auto minSpeed2 = Broadcast(constants.maxUnitBackwardSpeed * constants.maxUnitBackwardSpeed);
+    auto speedRange = Broadcast(constants.maxUnitForwardSpeed - constants.maxUnitBackwardSpeed);
+    auto speedProduct = Broadcast(constants.maxUnitBackwardSpeed * constants.maxUnitForwardSpeed);
+    auto two = Broadcast(2);
+    auto factor = Broadcast(limitFactor);
+
+    for (int i = 0; i < BATCH_SIZE; i += PACK_WIDTH) {
+        auto vx = Load(velocity.X + i);
+        auto vy = Load(velocity.Y + i);
+        auto dx = Load(direction.X + i);
+        auto dy = Load(direction.Y + i);
+
+        auto velocityAbs2 = vx * vx + vy * vy;
+        auto slow = velocityAbs2 < minSpeed2;
+
+        auto directionAbs = Sqrt(dx * dx + dy * dy);
+        auto velocityAbs = Sqrt(velocityAbs2);
+        auto nvx = vx / velocityAbs;
+        auto nvy = vy / velocityAbs;
+        auto projection = ((dx / directionAbs) * nvx + (dy / directionAbs) * nvy) * speedRange / two;
+
+        auto limit = (Sqrt(projection * projection + speedProduct) + projection) * factor;
+
+        auto keep = slow | (velocityAbs < limit);
+        Store(velocity.X + i, Select(keep, vx, nvx * limit));
+        Store(velocity.Y + i, Select(keep, vy, nvy * limit));
+    }
+}
+
+// TWorld::ApplyAcceleration, velocity is updated in place
+void ApplyAccelerations(TLaneVectors& velocity, const TLaneVectors& targetVelocity, const TConstants& constants) {
+    auto maxDeltaChange = Broadcast(constants.unitAcceleration / constants.ticksPerSecond);
+
+    for (int i = 0; i < BATCH_SIZE; i += PACK_WIDTH) {
+        auto vx = Load(velocity.X + i);
+        auto vy = Load(velocity.Y + i);
+        auto tx = Load(targetVelocity.X + i);
+        auto ty = Load(targetVelocity.Y + i);
+
+        auto deltaX = tx - vx;
+        auto deltaY = ty - vy;
+        auto deltaAbs = Sqrt(deltaX * deltaX + deltaY * deltaY);
+        auto clip = deltaAbs > maxDeltaChange;
+
+        Store(velocity.X + i, Select(clip, vx + (deltaX / deltaAbs) * maxDeltaChange, tx));
+        Store(velocity.Y + i, Select(clip, vy + (deltaY / deltaAbs) * maxDeltaChange, ty));
+    }
+}
+
+// TWorld::RotateUnit, direction is updated in place
+void RotateUnits(TLaneVectors& direction, const TLaneVectors& targetDirection, const TConstants& constants) {
+    double maxAngle = constants.rotationSpeed / 180 * M_PI / constants.ticksPerSecond;
+    auto minTarget2 = Broadcast(constants.unitRadius * constants.unitRadius / 4);
+    auto sinMaxAngle = Broadcast(sin(maxAngle));
+    auto cosMaxAngle = Broadcast(cos(maxAngle));
+
+    for (int i = 0; i < BATCH_SIZE; i += PACK_WIDTH) {
+        auto dx = Load(direction.X + i);
+        auto dy = Load(direction.Y + i);
+        auto tx = Load(targetDirection.X + i);
+        auto ty = Load(targetDirection.Y + i);
+
+        auto targetAbs2 = tx * tx + ty * ty;
+        auto skip = targetAbs2 <= minTarget2;
+
+        auto targetAbs = Sqrt(targetAbs2);
+        tx = tx / targetAbs;
+        ty = ty / targetAbs;
+
+        auto directionAbs2 = dx * dx + dy * dy;
+        auto k = (tx * dx + ty * dy) / directionAbs2;
+        auto normalX = tx - dx * k;
+        auto normalY = ty - dy * k;
+
+        auto directionAbs = Sqrt(directionAbs2);
+        auto snap = (normalX * tx + normalY * ty) < sinMaxAngle;
+
+        auto rotatedX = Select(snap, tx, (dx / directionAbs) * cosMaxAngle + normalX * sinMaxAngle);
+        auto rotatedY = Select(snap, ty, (dy / directionAbs) * cosMaxAngle + normalY * sinMaxAngle);
+
+        Store(direction.X + i, Select(skip, dx, rotatedX));
+        Store(direction.Y + i, Select(skip, dy, rotatedY));
+    }
+}
+
+// SegmentIntersectsCircle of the projectile's relative path against the unit of every lane, bit k is lane k
+uint32_t SegmentsIntersectCircles(const TProjectile& projectile, const TLaneVectors& position, const TLaneVectors& velocity, const TConstants& constants) {
+    auto ticksPerSecond = Broadcast(constants.ticksPerSecond);
+    auto radius = Broadcast(constants.unitRadius);
+    auto radius2 = Broadcast(constants.unitRadius * constants.unitRadius);
+    auto zero = Broadcast(0);
+    auto fromX = Broadcast(projectile.Position.x);
+    auto fromY = Broadcast(projectile.Position.y);
+    auto projectileVx = Broadcast(projectile.Velocity.x);
+    auto projectileVy = Broadcast(projectile.Velocity.y);
+
+    uint32_t hits = 0;
+    for (int i = 0; i < BATCH_SIZE; i += PACK_WIDTH) {
+        auto toX = fromX + (projectileVx - Load(velocity.X + i)) / ticksPerSecond;
+        auto toY = fromY + (projectileVy - Load(velocity.Y + i)) / ticksPerSecond;
+        auto cx = Load(position.X + i);
+        auto cy = Load(position.Y + i);
+
+        auto c1x = cx - fromX;
+        auto c1y = cy - fromY;
+        auto c2x = cx - toX;
+        auto c2y = cy - toY;
+        auto tx = toX - fromX;
+        auto ty = toY - fromY;
+
+        auto inside = ((c1x * c1x + c1y * c1y) < radius2) | ((c2x * c2x + c2y * c2y) < radius2);
+        auto crossesNormal = ((c1x * tx + c1y * ty) > zero) ^ ((c2x * tx + c2y * ty) > zero);
+        auto closeToLine = (Fabs(tx * c1y - ty * c1x) / Sqrt(tx * tx + ty * ty)) < radius;
+
+        hits |= ToBits(inside | (crossesNormal & closeToLine)) << i;
+    }
+    return hits;
+}
+
+bool TBatchEmulator::Evaluate(const TStrategy* const* strategies, int nStrategies, TRollout& rollout, int unitId, int untilTick, TScore* scores,
+                              TDeadline deadline) {
+    assert(0 < nStrategies && nStrategies <= BATCH_SIZE);
+
+    const auto& root = rollout.Root();
+    assert(root.StateByUnitId.contains(unitId));
+    auto& world = rollout.World();
+    if (!world.Constants_) {
+        world.Constants_ = GetGlobalConstants();
+    }
+    assert(world.Constants_);
+
+    int plannedSlot = world.Units.GetSlot(unitId);
+    assert(plannedSlot != -1);
+    auto& plannedUnit = world.Units[plannedSlot];
+    auto& plannedState = world.StateByUnitId[unitId];
+
+    // lanes past nStrategies keep valid copies, so the kernels never see garbage
+    Units_.fill(plannedUnit);
+    States_.fill(plannedState);
+    for (int lane = 0; lane < nStrategies; ++lane) {
+        scores[lane] = {0, {std::nullopt}, 0};
+    }
+
+    Projectiles_.assign(world.Projectiles.begin(), world.Projectiles.end());
+    AliveLanes_.assign(Projectiles_.size(), (uint32_t(1) << nStrategies) - 1);
+
+    PlannedSlot_ = plannedSlot;
+    NLanes_ = nStrategies;
+    SplitSlots_.clear();
+    IsSplit_.assign(world.Units.Size(), 0);
+    LaneHealth_.resize(world.Units.Size());
+
+    bool completed = true;
+    while (world.CurrentTick < untilTick) {
+        if (deadline != NO_DEADLINE && std::chrono::high_resolution_clock::now() > deadline) {
+            completed = false;
+            break;
+        }
+        for (int lane = 0; lane < nStrategies; ++lane) {
+            plannedUnit = Units_[lane];
+            States_[lane].Sync(world);
+        }
+
+        MoveProjectiles(world, plannedSlot, nStrategies);
+        world.MoveEnemies();
+        for (int slot = 0; slot < world.Units.Size(); ++slot) {
+            if (slot == plannedSlot || world.Units[slot].PlayerId != world.MyId) {
+                continue;
+            }
+            auto& unit = world.Units[slot];
+            if (!IsSplit_[slot]) {
+                world.ApplyEnvironmentDamage(unit);
+                continue;
+            }
+            // the spawn timer must advance once per tick, not once per lane
+            auto remainingSpawnTime = unit.RemainingSpawnTime;
+            for (int lane = 0; lane < nStrategies; ++lane) {
+                unit.Health = LaneHealth_[slot][lane];
+                unit.RemainingSpawnTime = remainingSpawnTime;
+                world.ApplyEnvironmentDamage(unit);
+                LaneHealth_[slot][lane] = unit.Health;
+            }
+        }
+        for (int lane = 0; lane < nStrategies; ++lane) {
+            world.ApplyEnvironmentDamage(Units_[lane]);
+        }
+        UseLaneHealth(world, 0);
+        world.EmulateTeammates(unitId);
+
+        for (int lane = 0; lane < nStrategies; ++lane) {
+            plannedUnit = Units_[lane];
+            plannedState = States_[lane];
+            UseLaneHealth(world, lane);
+            Orders_[lane] = strategies[lane]->GetOrder(world, unitId);
+        }
+        for (int lane = nStrategies; lane < BATCH_SIZE; ++lane) {
+            Orders_[lane] = Orders_[0];
+        }
+
+        EmulateOrders(world, nStrategies);
+        for (int lane = 0; lane < nStrategies; ++lane) {
+            States_[lane].Update(world, Orders_[lane]);
+        }
+        world.Tick();
+
+        for (int lane = 0; lane < nStrategies; ++lane) {
+            scores[lane] = scores[lane] + EvaluateWorld(root, Units_[lane]);
+        }
+    }
+
+    FinalHealth_.resize(world.Units.Size());
+    for (int slot = 0; slot < world.Units.Size(); ++slot) {
+        FinalHealth_[slot] = world.Units[slot].Health;
+    }
+
+    rollout.Rewind();
+    return completed;
+}
+
+double TBatchEmulator::GetUnitHealth(int slot, int lane) const {
+    assert(0 <= lane && lane < NLanes_);
+    if (slot == PlannedSlot_) {
+        return Units_[lane].Health;
+    }
+    if (IsSplit_[slot]) {
+        return LaneHealth_[slot][lane];
+    }
+    return FinalHealth_[slot];
+}
+
+// Subtracts damage in the given lanes, splitting the unit's health by lane the first time they are not all of them
+void TBatchEmulator::DamageSharedUnit(TWorld& world, int slot, uint32_t lanes, double damage) {
+    if (!IsSplit_[slot] && lanes == (uint32_t(1) << NLanes_) - 1) {
+        world.Units[slot].Health -= damage;
+        return;
+    }
+    if (!IsSplit_[slot]) {
+        IsSplit_[slot] = 1;
+        SplitSlots_.push_back(slot);
+        LaneHealth_[slot].fill(world.Units[slot].Health);
+    }
+    for (int lane = 0; lane < NLanes_; ++lane) {
+        if (lanes >> lane & 1) {
+            LaneHealth_[slot][lane] -= damage;
+        }
+    }
+}
+
+// Split units show the health of the lane, so lanes read the world like their own scalar emulation would
+void TBatchEmulator::UseLaneHealth(TWorld& world, int lane) const {
+    for (auto slot: SplitSlots_) {
+        world.Units[slot].Health = LaneHealth_[slot][lane];
+    }
+}
+
+// TWorld::MoveProjectile over the shared projectiles; only the planned unit differs between lanes
+void TBatchEmulator::MoveProjectiles(TWorld& world, int plannedSlot, int nLanes) {
+    const auto& constants = *world.Constants_;
+
+    TLaneVectors position, velocity;
+    Vector2D center{0, 0};
+    for (int lane = 0; lane < BATCH_SIZE; ++lane) {
+        position.X[lane] = Units_[lane].Position.x;
+        position.Y[lane] = Units_[lane].Position.y;
+        velocity.X[lane] = Units_[lane].Velocity.x;
+        velocity.Y[lane] = Units_[lane].Velocity.y;
+        center = center + Units_[lane].Position / BATCH_SIZE;
+    }
+
+    // the lanes stay close to each other, so a projectile missing the circle around all of them
+    // misses every lane, the relative path is off the absolute one by at most the unit's own step
+    double spread = 0;
+    for (int lane = 0; lane < BATCH_SIZE; ++lane) {
+        spread = std::max(spread, abs(Units_[lane].Position - center) + abs(Units_[lane].Velocity) / constants.ticksPerSecond);
+    }
+    // one more unit radius of slack for rounding
+    double laneCircleRadius = spread + 2 * constants.unitRadius;
+
+    int newSize = 0;
+    for (int i = 0; i < static_cast<int>(Projectiles_.size()); ++i) {
+        auto projectile = Projectiles_[i];
+        auto aliveLanes = AliveLanes_[i];
+
+        projectile.LifeTime -= 1 / constants.ticksPerSecond;
+        if (projectile.LifeTime < 0) {
+            continue;
+        }
+        auto newPosition = projectile.Position + projectile.Velocity / constants.ticksPerSecond;
+
+        auto obstacle = constants.obstaclesMeta.GetObstacle(projectile.Position);
+        if (obstacle && !constants.obstacles[*obstacle].CanShootThrough) {
+            continue;
+        }
+
+        int shooterPlayerId = -1;
+        if (const auto* shooter = world.Units.Find(projectile.ShooterId)) {
+            shooterPlayerId = shooter->PlayerId;
+        }
+        auto damage = constants.weapons[projectile.WeaponTypeIndex].projectileDamage;
+
+        // the first unit on the way takes the hit, the planned unit is tested in every lane at its own slot
+        for (int slot = 0; slot < world.Units.Size() && aliveLanes; ++slot) {
+            if (slot == plannedSlot) {
+                if (!SegmentIntersectsCircle(projectile.Position, newPosition, center, laneCircleRadius)) {
+                    continue;
+                }
+                auto hitLanes = SegmentsIntersectCircles(projectile, position, velocity, constants) & aliveLanes;
+                if (Units_[0].PlayerId != shooterPlayerId) {
+                    for (int lane = 0; lane < nLanes; ++lane) {
+                        if (hitLanes >> lane & 1) {
+                            Units_[lane].Health -= damage;
+                        }
+                    }
+                }
+                aliveLanes &= ~hitLanes;
+                continue;
+            }
+
+            auto& unit = world.Units[slot];
+            if (SegmentIntersectsCircle(projectile.Position, projectile.Position + (projectile.Velocity - unit.Velocity) / constants.ticksPerSecond, unit.Position, constants.unitRadius)) {
+                if (unit.PlayerId != shooterPlayerId) {
+                    DamageSharedUnit(world, slot, aliveLanes, damage);
+                }
+                aliveLanes = 0;
+            }
+        }
+        if (!aliveLanes) {
+            continue;
+        }
+
+        projectile.Position = newPosition;
+        Projectiles_[newSize] = projectile;
+        AliveLanes_[newSize] = aliveLanes;
+        ++newSize;
+    }
+
+    Projectiles_.resize(newSize);
+    AliveLanes_.resize(newSize);
+}
+
+// TWorld::EmulateOrder for every lane
+void TBatchEmulator::EmulateOrders(TWorld& world, int nLanes) {
+    const auto& constants = *world.Constants_;
+    assert(constants.maxUnitBackwardSpeed < constants.maxUnitForwardSpeed);
+
+    double limitFactor = world.GetAimSpeedFactor(Units_[0]);
+
+    TLaneVectors targetVelocity, velocity, direction, targetDirection;
+    for (int lane = 0; lane < BATCH_SIZE; ++lane) {
+        targetVelocity.X[lane] = Orders_[lane].TargetVelocity.x;
+        targetVelocity.Y[lane] = Orders_[lane].TargetVelocity.y;
+        velocity.X[lane] = Units_[lane].Velocity.x;
+        velocity.Y[lane] = Units_[lane].Velocity.y;
+        direction.X[lane] = Units_[lane].Direction.x;
+        direction.Y[lane] = Units_[lane].Direction.y;
+        targetDirection.X[lane] = Orders_[lane].TargetDirection.x;
+        targetDirection.Y[lane] = Orders_[lane].TargetDirection.y;
+    }
+
+    ClipVelocities(targetVelocity, direction, constants, limitFactor);
+    ApplyAccelerations(velocity, targetVelocity, constants);
+    for (int lane = 0; lane < nLanes; ++lane) {
+        world.MoveCollidingUnit(Units_[lane], {velocity.X[lane], velocity.Y[lane]});
+    }
+
+    // collisions move the unit but never turn it, so the gathered directions are still current
+    RotateUnits(direction, targetDirection, constants);
+    for (int lane = 0; lane < nLanes; ++lane) {
+        Units_[lane].Direction = {direction.X[lane], direction.Y[lane]};
+    }
+}
+
+}
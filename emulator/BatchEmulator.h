@@ -0,0 +1,58 @@
+#pragma once
+
+#include "public.h"
+#include "Evaluation.h"
+#include "Strategy.h"
+#include "World.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Emulator {
+
+// Lanes are processed by the kernels four doubles at a time
+constexpr int BATCH_SIZE = 8;
+
+// Emulates up to BATCH_SIZE strategies of one unit in lockstep.
+// Everything except the planned unit evolves the same way in every lane, so projectiles, enemies and
+// teammates are advanced once per tick; a lane keeps only its copy of the unit, its state and
+// the projectiles it has already absorbed. Movement and hit tests run across all lanes at once.
+// A projectile absorbed by the planned unit in some lanes only may still hit another unit in the rest,
+// from then on that unit's health is kept per lane. Teammates are emulated once for all lanes,
+// against the health of lane 0.
+class TBatchEmulator {
+public:
+    // Scores strategies[i] into scores[i] exactly like EvaluateStrategy would, rollout is rewound afterwards.
+    // Returns false if the deadline interrupted the lanes, their scores are partial then
+    bool Evaluate(const TStrategy* const* strategies, int nStrategies, TRollout& rollout, int unitId, int untilTick, TScore* scores,
+                  TDeadline deadline = NO_DEADLINE);
+
+    // Health the unit in slot ended the last Evaluate with in lane
+    double GetUnitHealth(int slot, int lane) const;
+
+private:
+    void MoveProjectiles(TWorld& world, int plannedSlot, int nLanes);
+    void EmulateOrders(TWorld& world, int nLanes);
+    void DamageSharedUnit(TWorld& world, int slot, uint32_t lanes, double damage);
+    void UseLaneHealth(TWorld& world, int lane) const;
+
+    std::array<TUnit, BATCH_SIZE> Units_;
+    std::array<TState, BATCH_SIZE> States_;
+    std::array<TOrder, BATCH_SIZE> Orders_;
+
+    // projectiles of the shared world, AliveLanes_[i] has bit k set while Projectiles_[i] exists in lane k
+    std::vector<TProjectile> Projectiles_;
+    std::vector<uint32_t> AliveLanes_;
+
+    // shared units whose health differs between lanes, LaneHealth_[slot] is valid for them
+    std::vector<int> SplitSlots_;
+    std::vector<uint8_t> IsSplit_;
+    std::vector<std::array<double, BATCH_SIZE>> LaneHealth_;
+    int PlannedSlot_{-1};
+    int NLanes_{0};
+    // health of every unit when the last Evaluate ended, split units and the planned unit excluded
+    std::vector<double> FinalHealth_;
+};
+
+}
@@ -1,7 +1,12 @@
 #include "Constants.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <stdexcept>
 
 namespace Emulator {
 
@@ -12,7 +17,34 @@ TConstantsPtr GetGlobalConstants() {
 }
 
 void SetGlobalConstants(TConstants constants) {
+    if (constants.weapons.size() > MAX_WEAPON_TYPES) {
+        throw std::runtime_error("Too many weapon types");
+    }
     GlobalConstants = std::make_unique<TConstants>(std::move(constants));
+    // built eagerly: rollouts read the index concurrently from evaluation workers
+    GlobalConstants->obstaclesMeta = TObstacleMeta(GlobalConstants->obstacles);
+    GlobalConstants->weaponCombat = BuildWeaponCombat(*GlobalConstants);
+}
+
+std::vector<TWeaponCombat> BuildWeaponCombat(const TConstants& constants) {
+    std::vector<TWeaponCombat> output;
+    output.reserve(constants.weapons.size());
+    for (const auto& weapon: constants.weapons) {
+        auto maxHitsToKill = std::lround(std::ceil(constants.maxShield / weapon.projectileDamage))
+            + std::lround(std::ceil(constants.unitHealth / weapon.projectileDamage));
+
+        TWeaponCombat combat{
+            .CombatRadius = weapon.projectileSpeed * weapon.projectileLifeTime,
+            .ProjectileDamage = weapon.projectileDamage,
+            .RoundsPerSecond = weapon.roundsPerSecond,
+        };
+        combat.PowerByHitsToKill.resize(std::max(maxHitsToKill, 1l) + 1);
+        for (int hitsToKill = 1; hitsToKill < static_cast<int>(combat.PowerByHitsToKill.size()); ++hitsToKill) {
+            combat.PowerByHitsToKill[hitsToKill] = weapon.roundsPerSecond / ((double)hitsToKill);
+        }
+        output.push_back(std::move(combat));
+    }
+    return output;
 }
 
 TConstants TConstants::FromAPI(const model::Constants &apiConstants) {
@@ -200,23 +232,62 @@ std::istream& operator>>(std::istream& in, TConstants& c) {
 }
 
 std::pair<int, int> ToCellId(Vector2D position) {
-    return {position.x, position.y};
+    return {static_cast<int>(std::floor(position.x)), static_cast<int>(std::floor(position.y))};
+}
+
+bool BlocksLine(const TObstacle& obstacle, ELineKind kind) {
+    return kind == LINE_OF_SIGHT ? !obstacle.CanSeeThrough : !obstacle.CanShootThrough;
 }
 
 TObstacleMeta::TObstacleMeta(): Initialized_(false) {
 }
 
 TObstacleMeta::TObstacleMeta(const std::vector<TObstacle> &obstacles): Initialized_(true), Obstacles_(obstacles) {
-    for (int i = 0; i < obstacles.size(); ++i) {
-        auto [xMin, yMin] = ToCellId(
-            obstacles[i].Center - Vector2D{1, 1} * (obstacles[i].Radius + GetGlobalConstants()->unitRadius));
+    std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> cellBoxes;
+    cellBoxes.reserve(obstacles.size());
+    for (const auto& obstacle: obstacles) {
+        cellBoxes.emplace_back(
+            ToCellId(obstacle.Center - Vector2D{1, 1} * (obstacle.Radius + GetGlobalConstants()->unitRadius)),
+            ToCellId(obstacle.Center + Vector2D{1, 1} * (obstacle.Radius + GetGlobalConstants()->unitRadius)));
+    }
+    if (cellBoxes.empty()) {
+        CellOffsets_.assign(1, 0);
+        return;
+    }
 
-        auto [xMax, yMax] = ToCellId(
-            obstacles[i].Center + Vector2D{1, 1} * (obstacles[i].Radius + GetGlobalConstants()->unitRadius));
+    int maxCellX = cellBoxes[0].second.first;
+    int maxCellY = cellBoxes[0].second.second;
+    MinCellX_ = cellBoxes[0].first.first;
+    MinCellY_ = cellBoxes[0].first.second;
+    for (const auto& [minCell, maxCell]: cellBoxes) {
+        MinCellX_ = std::min(MinCellX_, minCell.first);
+        MinCellY_ = std::min(MinCellY_, minCell.second);
+        maxCellX = std::max(maxCellX, maxCell.first);
+        maxCellY = std::max(maxCellY, maxCell.second);
+    }
+    Width_ = maxCellX - MinCellX_ + 1;
+    Height_ = maxCellY - MinCellY_ + 1;
+
+    // counting sort by cell; obstacles are visited in id order, so every cell lists its ids sorted
+    CellOffsets_.assign(Width_ * Height_ + 1, 0);
+    for (const auto& [minCell, maxCell]: cellBoxes) {
+        for (int y = minCell.second; y <= maxCell.second; ++y) {
+            for (int x = minCell.first; x <= maxCell.first; ++x) {
+                ++CellOffsets_[(y - MinCellY_) * Width_ + (x - MinCellX_) + 1];
+            }
+        }
+    }
+    for (int cell = 0; cell < Width_ * Height_; ++cell) {
+        CellOffsets_[cell + 1] += CellOffsets_[cell];
+    }
 
-        for (int x = xMin; x <= xMax; ++x) {
-            for (int y = yMin; y <= yMax; ++y) {
-                Index_[{x, y}].push_back(i);
+    CellIds_.resize(CellOffsets_.back());
+    std::vector<int> cellEnds(CellOffsets_.begin(), CellOffsets_.end() - 1);
+    for (int i = 0; i < static_cast<int>(cellBoxes.size()); ++i) {
+        const auto& [minCell, maxCell] = cellBoxes[i];
+        for (int y = minCell.second; y <= maxCell.second; ++y) {
+            for (int x = minCell.first; x <= maxCell.first; ++x) {
+                CellIds_[cellEnds[(y - MinCellY_) * Width_ + (x - MinCellX_)]++] = i;
             }
         }
     }
@@ -226,16 +297,23 @@ bool TObstacleMeta::IsInitialized() const {
     return Initialized_;
 }
 
-const std::vector<int>& TObstacleMeta::GetIntersectingIds(Vector2D point) {
-    auto it = Index_.find(ToCellId(point));
-    if (it == Index_.end()) {
-        return EmptyList_;
+std::span<const int> TObstacleMeta::GetIntersectingIds(Vector2D point) const {
+    auto [x, y] = ToCellId(point);
+    return GetCellIds(x, y);
+}
+
+std::span<const int> TObstacleMeta::GetCellIds(int x, int y) const {
+    auto column = static_cast<unsigned>(x - MinCellX_);
+    auto row = static_cast<unsigned>(y - MinCellY_);
+    if (column >= static_cast<unsigned>(Width_) || row >= static_cast<unsigned>(Height_)) {
+        return {};
     }
 
-    return it->second;
+    auto cell = row * Width_ + column;
+    return {CellIds_.data() + CellOffsets_[cell], CellIds_.data() + CellOffsets_[cell + 1]};
 }
 
-std::optional<int> TObstacleMeta::GetObstacle(Vector2D point) {
+std::optional<int> TObstacleMeta::GetObstacle(Vector2D point) const {
     for (auto& id: GetIntersectingIds(point)) {
         auto obstacle = Obstacles_[id];
         if (abs2(obstacle.Center - point) < obstacle.Radius * obstacle.Radius) {
@@ -245,65 +323,73 @@ std::optional<int> TObstacleMeta::GetObstacle(Vector2D point) {
     return std::nullopt;
 }
 
-bool TObstacleMeta::SegmentIntersectsObstacleNearPoint(Vector2D p1, Vector2D p2, Vector2D p, std::unordered_set<int>& obstacles) {
-    auto constants = GetGlobalConstants();
-    assert(constants);
+// Obstacles seen by the current walk of this thread are stamped with its generation
+struct TObstacleStamps {
+    std::vector<uint32_t> StampById;
+    uint32_t Generation{0};
 
-    for (auto id: GetIntersectingIds(p)) {
-        if (obstacles.contains(id)) {
-            continue;
+    void StartWalk(size_t nObstacles) {
+        if (StampById.size() < nObstacles) {
+            StampById.resize(nObstacles, 0);
         }
-        obstacles.insert(id);
-        auto& obstacle = constants->obstacles[id];
-        if (obstacle.CanShootThrough) {
-            continue;
-        }
-        if (SegmentIntersectsCircle(p1, p2, obstacle.Center, obstacle.Radius)) {
-            return true;
+        if (++Generation == 0) {
+            std::fill(StampById.begin(), StampById.end(), 0);
+            Generation = 1;
         }
     }
-    return false;
-}
 
-bool TObstacleMeta::SubSegmentIntersectsObstacle(Vector2D p1, Vector2D p2, std::unordered_set<int>& obstacles) {
-    auto c1 = ToCellId(p1);
-    auto c2 = ToCellId(p2);
-    Vector2D m = (p1 + p2) / 2;
-    auto cm = ToCellId(m);
-
-    if (c1 != cm && cm != c2) {
-        if (SegmentIntersectsObstacleNearPoint(p1, p2, m, obstacles)) {
-            return true;
+    // Returns false if the obstacle was already seen by this walk
+    bool Visit(int id) {
+        if (StampById[id] == Generation) {
+            return false;
         }
-    }
-
-    if (c1 == cm || cm == c2) {
-        return false;
-    }
-
-    if (SubSegmentIntersectsObstacle(p1, m, obstacles)) {
-        return true;
-    }
-    if (SubSegmentIntersectsObstacle(m, p2, obstacles)) {
+        StampById[id] = Generation;
         return true;
     }
+};
+
+bool TObstacleMeta::SegmentIntersectsObstacle(Vector2D p1, Vector2D p2, ELineKind kind) const {
+    thread_local TObstacleStamps stamps;
+    stamps.StartWalk(Obstacles_.size());
+
+    auto [x, y] = ToCellId(p1);
+    auto [xEnd, yEnd] = ToCellId(p2);
+    auto delta = p2 - p1;
+
+    // Amanatides-Woo: t is the segment parameter at which the walk crosses the next vertical or horizontal cell border
+    int stepX = delta.x > 0 ? 1 : -1;
+    int stepY = delta.y > 0 ? 1 : -1;
+    double tMaxX = delta.x != 0 ? (x + (stepX > 0) - p1.x) / delta.x : std::numeric_limits<double>::infinity();
+    double tMaxY = delta.y != 0 ? (y + (stepY > 0) - p1.y) / delta.y : std::numeric_limits<double>::infinity();
+    double tDeltaX = delta.x != 0 ? stepX / delta.x : std::numeric_limits<double>::infinity();
+    double tDeltaY = delta.y != 0 ? stepY / delta.y : std::numeric_limits<double>::infinity();
+
+    // exactly one step per crossed border, so rounding can never carry the walk past the last cell
+    int nSteps = std::abs(xEnd - x) + std::abs(yEnd - y);
+    for (int step = 0; ; ++step) {
+        for (auto id: GetCellIds(x, y)) {
+            if (!stamps.Visit(id)) {
+                continue;
+            }
+            const auto& obstacle = Obstacles_[id];
+            if (!BlocksLine(obstacle, kind)) {
+                continue;
+            }
+            if (SegmentIntersectsCircle(p1, p2, obstacle.Center, obstacle.Radius)) {
+                return true;
+            }
+        }
 
-    return false;
-}
-
-bool TObstacleMeta::SegmentIntersectsObstacle(Vector2D p1, Vector2D p2) {
-    auto constants = GetGlobalConstants();
-    assert(constants);
-    std::unordered_set<int> obstacles;
-
-    if (SegmentIntersectsObstacleNearPoint(p1, p2, p1, obstacles)) {
-        return true;
-    }
-    if (SegmentIntersectsObstacleNearPoint(p1, p2, p2, obstacles)) {
-        return true;
-    }
-    if (SubSegmentIntersectsObstacle(p1, p2, obstacles)) {
-        return true;
+        if (step == nSteps) {
+            break;
+        }
+        if (y == yEnd || (x != xEnd && tMaxX < tMaxY)) {
+            x += stepX;
+            tMaxX += tDeltaX;
+        } else {
+            y += stepY;
+            tMaxY += tDeltaY;
+        }
     }
 
     return false;
@@ -6,22 +6,10 @@
 #include "model/Constants.hpp"
 
 #include <unordered_map>
-#include <unordered_set>
 #include <map>
+#include <span>
 #include <vector>
 
-struct hash_pair {
-    size_t operator()(const std::pair<int, int>& p) const
-    {
-        auto a = p.first;
-        auto b = p.second;
-        auto A = (ulong)(a >= 0 ? 2 * (long)a : -2 * (long)a - 1);
-        auto B = (ulong)(b >= 0 ? 2 * (long)b : -2 * (long)b - 1);
-        auto C = (long)((A >= B ? A * A + A + B : A + B * B) / 2);
-        return a < 0 && b < 0 || a >= 0 && b >= 0 ? C : -C - 1;
-    }
-};
-
 namespace Emulator {
 
 struct TObstacle {
@@ -31,30 +19,61 @@ struct TObstacle {
     bool CanShootThrough;
 };
 
+enum ELineKind {
+    // blocked by obstacles with !CanSeeThrough
+    LINE_OF_SIGHT = 0,
+    // blocked by obstacles with !CanShootThrough
+    LINE_OF_FIRE = 1,
+};
+
+bool BlocksLine(const TObstacle& obstacle, ELineKind kind);
+
 class TObstacleMeta {
 public:
     TObstacleMeta();
     explicit TObstacleMeta(const std::vector<TObstacle>& obstacles);
 
-    const std::vector<int>& GetIntersectingIds(Vector2D point);
-    std::optional<int> GetObstacle(Vector2D point);
-    bool SegmentIntersectsObstacle(Vector2D p1, Vector2D p2);
+    // Ids in increasing order of every obstacle whose bounding box, grown by the unit radius, covers the point's cell
+    std::span<const int> GetIntersectingIds(Vector2D point) const;
+    std::optional<int> GetObstacle(Vector2D point) const;
+    // Exact test against every obstacle blocking this kind of line, walks the grid cells along the segment
+    bool SegmentIntersectsObstacle(Vector2D p1, Vector2D p2, ELineKind kind = LINE_OF_FIRE) const;
 
     bool IsInitialized() const;
 private:
     bool Initialized_ = false;
 
     std::vector<TObstacle> Obstacles_;
-    robin_hood::unordered_map<std::pair<int, int>, std::vector<int>, hash_pair> Index_;
-    std::vector<int> EmptyList_;
 
-    bool SubSegmentIntersectsObstacle(Vector2D p1, Vector2D p2, std::unordered_set<int>& obstacles);
-    bool SegmentIntersectsObstacleNearPoint(Vector2D p1, Vector2D p2, Vector2D p, std::unordered_set<int>& obstacles);
+    // Unit cells [x, x + 1) x [y, y + 1) covering the obstacles' bounding boxes, stored row by row.
+    // Ids of cell c are CellIds_[CellOffsets_[c], CellOffsets_[c + 1]), points outside the grid have no obstacles.
+    int MinCellX_{0};
+    int MinCellY_{0};
+    int Width_{0};
+    int Height_{0};
+    std::vector<int> CellOffsets_;
+    std::vector<int> CellIds_;
+
+    std::span<const int> GetCellIds(int x, int y) const;
+};
+
+// Units keep their ammo in fixed arrays, SetGlobalConstants rejects games with more weapon types
+constexpr size_t MAX_WEAPON_TYPES = 3;
+
+// Numbers of one weapon the combat evaluation needs, derived once in SetGlobalConstants
+struct TWeaponCombat {
+    // projectile speed times life time
+    double CombatRadius;
+    double ProjectileDamage;
+    double RoundsPerSecond;
+    // RoundsPerSecond / h for every hits to kill h a unit with full health and shield can need, index 0 is unused
+    std::vector<double> PowerByHitsToKill;
 };
 
 struct TConstants {
     std::vector<TObstacle> obstacles;
     TObstacleMeta obstaclesMeta;
+    std::vector<TWeaponCombat> weaponCombat;
 
     double realTicksPerSecond;
     // Number of ticks per game second
@@ -136,6 +155,7 @@ using TConstantsPtr = TConstants*;
 
 TConstantsPtr GetGlobalConstants();
 void SetGlobalConstants(TConstants obstacles);
+std::vector<TWeaponCombat> BuildWeaponCombat(const TConstants& constants);
 
 std::ostream& operator<<(std::ostream& out, const TConstants& c);
 
@@ -1,5 +1,7 @@
 #include "DebugSingleton.h"
 
+#ifdef DEBUG_VISUALISATION
+
 DebugInterface* GlobalDebugInterface;
 
 void SetGlobalDebugInterface(DebugInterface* value) {
@@ -9,3 +11,5 @@ void SetGlobalDebugInterface(DebugInterface* value) {
 DebugInterface* GetGlobalDebugInterface() {
     return GlobalDebugInterface;
 }
+
+#endif
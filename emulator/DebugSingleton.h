@@ -2,5 +2,27 @@
 
 #include "DebugInterface.hpp"
 
+// Visualisation is compiled in only with DEBUG_VISUALISATION (the ai_cup_22_debug target).
+// Without it the singleton is always empty and DEBUG_DRAW drops its call together with the arguments.
+#ifdef DEBUG_VISUALISATION
+
 void SetGlobalDebugInterface(DebugInterface* value);
 DebugInterface* GetGlobalDebugInterface();
+
+#define DEBUG_DRAW(call)                                              \
+    do {                                                              \
+        if (auto* globalDebugInterface = GetGlobalDebugInterface()) { \
+            globalDebugInterface->call;                               \
+        }                                                             \
+    } while (false)
+
+#else
+
+inline void SetGlobalDebugInterface(DebugInterface*) {}
+inline DebugInterface* GetGlobalDebugInterface() {
+    return nullptr;
+}
+
+#define DEBUG_DRAW(call) do { } while (false)
+
+#endif
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "robin_hood.h"
+
+#include <cassert>
+#include <type_traits>
+#include <vector>
+
+namespace Emulator {
+
+// Entities keyed by their Id field, stored contiguously in insertion order plus an id -> slot table.
+// Both parts are flat arrays, so copying a trivially copyable T is a couple of memcpy calls.
+// Erase keeps the relative order of the remaining entities; slots change after it.
+template <typename T>
+class TDenseMap {
+public:
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    iterator begin() { return Values_.begin(); }
+    iterator end() { return Values_.end(); }
+    const_iterator begin() const { return Values_.begin(); }
+    const_iterator end() const { return Values_.end(); }
+
+    [[nodiscard]] int Size() const { return static_cast<int>(Values_.size()); }
+    [[nodiscard]] bool Empty() const { return Values_.empty(); }
+
+    T& operator[](int slot) { return Values_[slot]; }
+    const T& operator[](int slot) const { return Values_[slot]; }
+
+    // Returns -1 if there is no entity with this id
+    [[nodiscard]] int GetSlot(int id) const {
+        auto it = SlotById_.find(id);
+        return it == SlotById_.end() ? -1 : it->second;
+    }
+
+    [[nodiscard]] bool Contains(int id) const {
+        return SlotById_.contains(id);
+    }
+
+    T* Find(int id) {
+        auto slot = GetSlot(id);
+        return slot == -1 ? nullptr : &Values_[slot];
+    }
+
+    const T* Find(int id) const {
+        auto slot = GetSlot(id);
+        return slot == -1 ? nullptr : &Values_[slot];
+    }
+
+    T& Get(int id) {
+        assert(Contains(id));
+        return Values_[SlotById_.find(id)->second];
+    }
+
+    const T& Get(int id) const {
+        assert(Contains(id));
+        return Values_[SlotById_.find(id)->second];
+    }
+
+    // Does nothing if an entity with the same id is already stored
+    bool Insert(const T& value) {
+        auto [it, inserted] = SlotById_.try_emplace(value.Id, Size());
+        if (inserted) {
+            Values_.push_back(value);
+        }
+        return inserted;
+    }
+
+    void InsertOrAssign(const T& value) {
+        if (!Insert(value)) {
+            Values_[SlotById_.find(value.Id)->second] = value;
+        }
+    }
+
+    // The predicate may modify the entity it is given
+    template <typename TPredicate>
+    void EraseIf(TPredicate predicate) {
+        int newSize = 0;
+        for (int slot = 0; slot < Size(); ++slot) {
+            if (predicate(Values_[slot])) {
+                SlotById_.erase(Values_[slot].Id);
+                continue;
+            }
+            if (newSize != slot) {
+                Values_[newSize] = Values_[slot];
+                SlotById_[Values_[newSize].Id] = newSize;
+            }
+            ++newSize;
+        }
+        Values_.resize(newSize);
+    }
+
+    void Erase(int id) {
+        EraseIf([id](const T& value) { return value.Id == id; });
+    }
+
+    void Clear() {
+        Values_.clear();
+        SlotById_.clear();
+    }
+
+    void Reserve(int size) {
+        Values_.reserve(size);
+        SlotById_.reserve(size);
+    }
+
+private:
+    std::vector<T> Values_;
+    robin_hood::unordered_flat_map<int, int> SlotById_;
+};
+
+}
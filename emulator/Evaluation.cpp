@@ -3,6 +3,7 @@
 
 #include "LootPicker.h"
 
+#include <array>
 #include <cassert>
 #include <iostream>
 
@@ -62,64 +63,84 @@ double AmmoCoefficient(int ammo) {
     return ((double) ammo) / ((double)enoughToKill);
 }
 
-double GetPower(const TUnit& killer, const TUnit& victim) {
+double GetPower(std::optional<int> killerWeapon, double victimHealth, double victimShield) {
     static auto constants = GetGlobalConstants();
     assert(constants);
 
-    if (!killer.Weapon) {
+    if (!killerWeapon) {
         return 0;
     }
 
-    auto& weapon = constants->weapons[*killer.Weapon];
+    const auto& combat = constants->weaponCombat[*killerWeapon];
 
     long hitsToKill = 0;
-    if (victim.Shield > 0.01) {
-        hitsToKill += std::lround(std::ceil(victim.Shield / weapon.projectileDamage));
+    if (victimShield > 0.01) {
+        hitsToKill += std::lround(std::ceil(victimShield / combat.ProjectileDamage));
     }
-    if (victim.Health > 0.01) {
-        hitsToKill += std::lround(std::ceil(victim.Health / weapon.projectileDamage));
+    if (victimHealth > 0.01) {
+        hitsToKill += std::lround(std::ceil(victimHealth / combat.ProjectileDamage));
     }
 
     hitsToKill = std::max(hitsToKill, 1l);
 
-    return weapon.roundsPerSecond / ((double)hitsToKill);
+    if (hitsToKill < static_cast<long>(combat.PowerByHitsToKill.size())) {
+        return combat.PowerByHitsToKill[hitsToKill];
+    }
+    return combat.RoundsPerSecond / ((double)hitsToKill);
 }
 
-double GetCombatSafety(const TWorld& world, const TUnit& unit, Vector2D unitPosition) {
-    const auto& state = world.StateByUnitId.find(unit.Id)->second;
+double GetCombatSafety(const std::vector<TThreat>& threats, const TState& state, const TUnit& unit, Vector2D unitPosition) {
     double combatSafety = 0;
     std::optional<double> minDist = std::nullopt;
-    int otherUnitId = -1;
+    const TThreat* nearestThreat = nullptr;
+    // the victim is the same for every threat, so its hits to kill are counted once per weapon
+    std::array<double, MAX_WEAPON_TYPES> powerAgainstUnit;
+    powerAgainstUnit.fill(-1);
 
     double radiusCoefficient = state.AutomatonState == RES_GATHERING ? 0.3:1;
 
-    for (auto& [_, otherUnit]: world.UnitById) {
-        if (otherUnit.PlayerId == world.MyId) {
-            continue;
-        }
-
-        auto dist = abs(unitPosition - otherUnit.Position);
-        auto otherUnitCombatRadius = otherUnit.GetCombatRadius() * radiusCoefficient;
-        if (dist < otherUnitCombatRadius) {
-            auto distanceCoefficient = (otherUnitCombatRadius - dist) / otherUnitCombatRadius;
-            combatSafety -= (GetPower(otherUnit, unit) + 1e-4) * distanceCoefficient * distanceCoefficient;
+    for (const auto& threat: threats) {
+        auto dist = abs(unitPosition - threat.Position);
+        auto threatCombatRadius = threat.CombatRadius * radiusCoefficient;
+        if (dist < threatCombatRadius) {
+            auto distanceCoefficient = (threatCombatRadius - dist) / threatCombatRadius;
+            double power = 0;
+            if (threat.Weapon) {
+                auto& cachedPower = powerAgainstUnit[*threat.Weapon];
+                if (cachedPower < 0) {
+                    cachedPower = GetPower(threat.Weapon, unit.Health, unit.Shield);
+                }
+                power = cachedPower;
+            }
+            combatSafety -= (power + 1e-4) * distanceCoefficient * distanceCoefficient;
         }
         if (!minDist || dist < *minDist) {
             minDist = dist;
-            otherUnitId = otherUnit.Id;
+            nearestThreat = &threat;
         }
     }
 
     auto unitCombatRadius = unit.GetCombatRadius() * radiusCoefficient;
     if (minDist && *minDist < unitCombatRadius && state.AutomatonState != RES_GATHERING) {
-        const auto& otherUnit = world.UnitById.find(otherUnitId)->second;
         auto distanceCoefficient = (unitCombatRadius - *minDist) / unitCombatRadius;
-        combatSafety += GetPower(unit, otherUnit) * distanceCoefficient * distanceCoefficient;
+        combatSafety += GetPower(unit.Weapon, nearestThreat->Health, nearestThreat->Shield) * distanceCoefficient * distanceCoefficient;
     }
 
     return combatSafety;
 }
 
+// Samples the world's threat table, worlds in the middle of an emulation collect their enemies on the spot
+double GetCombatSafety(const TWorld& world, const TUnit& unit, Vector2D unitPosition) {
+    const auto& state = world.StateByUnitId.find(unit.Id)->second;
+    if (const auto* threats = world.GetThreats()) {
+        return GetCombatSafety(*threats, state, unit, unitPosition);
+    }
+
+    static thread_local std::vector<TThreat> threats;
+    world.CollectThreats(threats);
+    return GetCombatSafety(threats, state, unit, unitPosition);
+}
+
 double GetCombatSafety(const TWorld& world, const TUnit& unit) {
     return GetCombatSafety(world, unit, unit.Position);
 }
@@ -161,17 +182,17 @@ TScore EvaluateWorld(const TWorld& world, const TUnit& unit) {
     return score;
 }
 
-TScore EvaluateStrategy(const TStrategy &strategy, const TWorld& world, int unitId, int untilTick) {
-    assert(world.StateByUnitId.contains(unitId));
-    const auto& state = world.StateByUnitId.find(unitId)->second;
-    TWorld currentWorld = world;
-    const auto& unit = currentWorld.UnitById[unitId];
-
-    TScore score = {0, {std::nullopt}, 0};
+bool EmulateStrategy(const TStrategy& strategy, TWorld& currentWorld, const TWorld& world, int unitId, int untilTick, TScore& score,
+                     TDeadline deadline) {
+    const auto& unit = currentWorld.Units.Get(unitId);
 
     while (currentWorld.CurrentTick < untilTick) {
+        if (deadline != NO_DEADLINE && std::chrono::high_resolution_clock::now() > deadline) {
+            return false;
+        }
         currentWorld.StateByUnitId[unitId].Sync(currentWorld);
         currentWorld.PrepareEmulation();
+        currentWorld.EmulateTeammates(unitId);
         auto order = strategy.GetOrder(currentWorld, unitId);
         currentWorld.EmulateOrder(order);
         currentWorld.StateByUnitId[unitId].Update(currentWorld, order);
@@ -179,6 +200,17 @@ TScore EvaluateStrategy(const TStrategy &strategy, const TWorld& world, int unit
 
         score = score + EvaluateWorld(world, unit);
     }
+    return true;
+}
+
+TScore EvaluateStrategy(const TStrategy &strategy, TRollout& rollout, int unitId, int untilTick) {
+    const auto& world = rollout.Root();
+    assert(world.StateByUnitId.contains(unitId));
+
+    TScore score = {0, {std::nullopt}, 0};
+    EmulateStrategy(strategy, rollout.World(), world, unitId, untilTick, score);
+
+    rollout.Rewind();
 
     return score;
 }
@@ -4,6 +4,8 @@
 #include "Strategy.h"
 #include "World.h"
 
+#include <chrono>
+
 namespace Emulator {
 
 struct TOptionalDouble {
@@ -31,6 +33,16 @@ bool operator<(TScore a, TScore b);
 double GetCombatSafety(const TWorld& world, const TUnit& unit);
 double GetCombatSafety(const TWorld& world, const TUnit& unit, Vector2D unitPosition);
 TScore EvaluateWorld(const TWorld& world, const TUnit& unit);
-TScore EvaluateStrategy(const TStrategy& strategy, const TWorld& world, int unitId, int untilTick);
+// Rollouts check it between ticks and give up once it has passed, so a single rollout never holds a tick hostage
+using TDeadline = std::chrono::high_resolution_clock::time_point;
+constexpr TDeadline NO_DEADLINE = TDeadline::max();
+
+// Emulates the strategy on currentWorld until untilTick and adds the score of every tick, taken against world.
+// Splitting an emulation into several calls adds the same numbers in the same order as a single call.
+// Returns false if the deadline interrupted it, currentWorld and score are left somewhere in between then
+bool EmulateStrategy(const TStrategy& strategy, TWorld& currentWorld, const TWorld& world, int unitId, int untilTick, TScore& score,
+                     TDeadline deadline = NO_DEADLINE);
+// Emulates the strategy on rollout.World() and rewinds it afterwards, the score is taken against rollout.Root()
+TScore EvaluateStrategy(const TStrategy& strategy, TRollout& rollout, int unitId, int untilTick);
 
 }
@@ -0,0 +1,260 @@
+#include "EvaluationPool.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <iterator>
+
+namespace Emulator {
+
+TEvaluationPool::TEvaluationPool(int nWorkers) {
+    if (nWorkers <= 0) {
+        nWorkers = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+
+    Workers_.resize(nWorkers);
+    for (int i = 0; i < nWorkers; ++i) {
+        Workers_[i].Index = i;
+    }
+
+    Threads_.reserve(nWorkers - 1);
+    for (int i = 1; i < nWorkers; ++i) {
+        Threads_.emplace_back(&TEvaluationPool::WorkerLoop, this, i);
+    }
+}
+
+TEvaluationPool::~TEvaluationPool() {
+    {
+        std::lock_guard lock(Mutex_);
+        Stopping_ = true;
+    }
+    WakeUp_.notify_all();
+    for (auto& thread: Threads_) {
+        thread.join();
+    }
+}
+
+int TEvaluationPool::Size() const {
+    return static_cast<int>(Workers_.size());
+}
+
+void TEvaluationPool::SetWorld(const TWorld& world, uint64_t seed) {
+    ParallelFor(Size(), [&](TEvaluationWorker& worker, int) {
+        std::seed_seq seedSequence{seed, static_cast<uint64_t>(worker.Index)};
+        worker.Random.seed(seedSequence);
+        worker.Rollout.Reset(world);
+        worker.PrefixCache.Clear();
+        return true;
+    });
+}
+
+void TEvaluationPool::ParallelFor(int nJobs, const TEvaluationJob& job) {
+    {
+        std::lock_guard lock(Mutex_);
+        assert(!Job_);
+        Job_ = &job;
+        NJobs_ = nJobs;
+        Pending_ = Size() - 1;
+        ++Generation_;
+    }
+    WakeUp_.notify_all();
+
+    RunJobs(Workers_[0]);
+
+    std::unique_lock lock(Mutex_);
+    Done_.wait(lock, [this] { return Pending_ == 0; });
+    Job_ = nullptr;
+}
+
+void TEvaluationPool::WorkerLoop(int workerIndex) {
+    int seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock lock(Mutex_);
+            WakeUp_.wait(lock, [&] { return Stopping_ || Generation_ != seenGeneration; });
+            if (Stopping_) {
+                return;
+            }
+            seenGeneration = Generation_;
+        }
+
+        RunJobs(Workers_[workerIndex]);
+
+        {
+            std::lock_guard lock(Mutex_);
+            --Pending_;
+        }
+        Done_.notify_one();
+    }
+}
+
+void TEvaluationPool::RunJobs(TEvaluationWorker& worker) {
+    for (int i = worker.Index; i < NJobs_; i += Size()) {
+        if (!(*Job_)(worker, i)) {
+            break;
+        }
+    }
+}
+
+bool IsBetter(const TEvaluatedStrategy& a, const TEvaluatedStrategy& b) {
+    if (a.Score < b.Score) {
+        return true;
+    }
+    if (b.Score < a.Score) {
+        return false;
+    }
+    return a.CandidateIndex < b.CandidateIndex;
+}
+
+TEvaluationResult TEvaluationPool::Evaluate(const TEvaluationRequest& request) {
+    assert(request.ForcedStrategies);
+    const auto& forcedStrategies = *request.ForcedStrategies;
+    int nForced = static_cast<int>(forcedStrategies.size());
+    int nCandidates = nForced + request.RandomStrategies;
+
+    std::vector<TEvaluationResult> resultByWorker(Size());
+
+    // job j emulates candidates [j * BATCH_SIZE, (j + 1) * BATCH_SIZE) in lockstep
+    ParallelFor((nCandidates + BATCH_SIZE - 1) / BATCH_SIZE, [&](TEvaluationWorker& worker, int jobIndex) {
+        int begin = jobIndex * BATCH_SIZE;
+        int end = std::min(begin + BATCH_SIZE, nCandidates);
+        auto now = std::chrono::high_resolution_clock::now();
+        if ((begin > nForced && now > request.Deadline) || now > request.HardDeadline) {
+            return false;
+        }
+
+        auto& result = resultByWorker[worker.Index];
+
+        std::array<TStrategy, BATCH_SIZE> randomStrategies;
+        std::array<const TStrategy*, BATCH_SIZE> strategies;
+        for (int i = begin; i < end; ++i) {
+            if (i < nForced) {
+                strategies[i - begin] = &forcedStrategies[i];
+            } else {
+                randomStrategies[i - begin] = GenerateRandomStrategy(worker.Rollout.Root().CurrentTick, request.ActionDuration, request.NActions, worker.Random);
+                strategies[i - begin] = &randomStrategies[i - begin];
+            }
+        }
+
+        std::array<TScore, BATCH_SIZE> scores;
+        if (!worker.Batch.Evaluate(strategies.data(), end - begin, worker.Rollout, request.UnitId, request.UntilTick, scores.data(),
+                                   request.HardDeadline)) {
+            return false;
+        }
+        int nBatchForced = std::clamp(nForced - begin, 0, end - begin);
+        result.ForcedEvaluated += nBatchForced;
+        result.RandomEvaluated += end - begin - nBatchForced;
+
+        for (int i = begin; i < end; ++i) {
+            // the strategy is only copied into candidates that become the best
+            TEvaluatedStrategy candidate{
+                .Strategy = {},
+                .Score = scores[i - begin],
+                .CandidateIndex = i,
+            };
+            if (!result.Best || IsBetter(candidate, *result.Best)) {
+                candidate.Strategy = *strategies[i - begin];
+                result.Best = std::move(candidate);
+            }
+        }
+        return true;
+    });
+
+    TEvaluationResult output;
+    for (auto& result: resultByWorker) {
+        output.ForcedEvaluated += result.ForcedEvaluated;
+        output.RandomEvaluated += result.RandomEvaluated;
+        if (result.Best && (!output.Best || IsBetter(*result.Best, *output.Best))) {
+            output.Best = std::move(result.Best);
+        }
+    }
+
+    return output;
+}
+
+std::vector<TEvaluatedStrategy> TEvaluationPool::EvaluateSampled(int count, const TStrategySampler& sample, int unitId, int untilTick,
+                                                                 std::chrono::high_resolution_clock::time_point deadline,
+                                                                 TDeadline hardDeadline) {
+    std::vector<std::vector<TEvaluatedStrategy>> candidatesByWorker(Size());
+
+    ParallelFor((count + BATCH_SIZE - 1) / BATCH_SIZE, [&](TEvaluationWorker& worker, int jobIndex) {
+        if (std::chrono::high_resolution_clock::now() > deadline) {
+            return false;
+        }
+        int begin = jobIndex * BATCH_SIZE;
+        int end = std::min(begin + BATCH_SIZE, count);
+
+        auto& candidates = candidatesByWorker[worker.Index];
+        auto batchBegin = candidates.size();
+        std::array<const TStrategy*, BATCH_SIZE> strategies;
+        for (int i = begin; i < end; ++i) {
+            candidates.push_back({
+                .Strategy = sample(worker.Random),
+                .CandidateIndex = i,
+            });
+        }
+        for (int i = begin; i < end; ++i) {
+            strategies[i - begin] = &candidates[batchBegin + i - begin].Strategy;
+        }
+
+        std::array<TScore, BATCH_SIZE> scores;
+        if (!worker.Batch.Evaluate(strategies.data(), end - begin, worker.Rollout, unitId, untilTick, scores.data(), hardDeadline)) {
+            candidates.resize(batchBegin);
+            return false;
+        }
+        for (int i = begin; i < end; ++i) {
+            candidates[batchBegin + i - begin].Score = scores[i - begin];
+        }
+        return true;
+    });
+
+    std::vector<TEvaluatedStrategy> output;
+    for (auto& candidates: candidatesByWorker) {
+        std::move(candidates.begin(), candidates.end(), std::back_inserter(output));
+    }
+    std::sort(output.begin(), output.end(), IsBetter);
+    return output;
+}
+
+std::vector<std::optional<TScore>> TEvaluationPool::EvaluateAll(const std::vector<TStrategy>& strategies, int unitId, int untilTick,
+                                                                 TDeadline hardDeadline) {
+    int nStrategies = static_cast<int>(strategies.size());
+    std::vector<std::optional<TScore>> output(nStrategies);
+
+    ParallelFor((nStrategies + BATCH_SIZE - 1) / BATCH_SIZE, [&](TEvaluationWorker& worker, int jobIndex) {
+        int begin = jobIndex * BATCH_SIZE;
+        int end = std::min(begin + BATCH_SIZE, nStrategies);
+
+        std::array<const TStrategy*, BATCH_SIZE> batch;
+        for (int i = begin; i < end; ++i) {
+            batch[i - begin] = &strategies[i];
+        }
+        std::array<TScore, BATCH_SIZE> scores;
+        if (!worker.Batch.Evaluate(batch.data(), end - begin, worker.Rollout, unitId, untilTick, scores.data(), hardDeadline)) {
+            return false;
+        }
+        std::copy(scores.begin(), scores.begin() + (end - begin), output.begin() + begin);
+        return true;
+    });
+
+    return output;
+}
+
+std::vector<std::optional<TScore>> TEvaluationPool::EvaluateCached(const std::vector<TStrategy>& strategies, int unitId, int untilTick,
+                                                                    std::chrono::high_resolution_clock::time_point deadline,
+                                                                    TDeadline hardDeadline) {
+    int nStrategies = static_cast<int>(strategies.size());
+    std::vector<std::optional<TScore>> output(nStrategies);
+
+    ParallelFor(nStrategies, [&](TEvaluationWorker& worker, int jobIndex) {
+        if (std::chrono::high_resolution_clock::now() > deadline) {
+            return false;
+        }
+        output[jobIndex] = worker.PrefixCache.Evaluate(strategies[jobIndex], worker.Rollout, unitId, untilTick, hardDeadline);
+        return output[jobIndex].has_value();
+    });
+
+    return output;
+}
+
+}
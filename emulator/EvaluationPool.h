@@ -0,0 +1,120 @@
+#pragma once
+
+#include "public.h"
+#include "BatchEmulator.h"
+#include "Evaluation.h"
+#include "PrefixCache.h"
+#include "Strategy.h"
+#include "World.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace Emulator {
+
+struct TEvaluationWorker {
+    int Index;
+    std::mt19937 Random;
+    // private copy of the root world, so workers never share emulation state
+    TRollout Rollout;
+    TBatchEmulator Batch;
+    // cleared by SetWorld
+    TPrefixCache PrefixCache;
+};
+
+// Returns false to stop the calling worker's share of the jobs
+using TEvaluationJob = std::function<bool(TEvaluationWorker& worker, int jobIndex)>;
+
+struct TEvaluatedStrategy {
+    TStrategy Strategy;
+    TScore Score;
+    int CandidateIndex;
+};
+
+struct TEvaluationRequest {
+    int UnitId;
+    int UntilTick;
+    const std::vector<TStrategy>* ForcedStrategies;
+    int RandomStrategies;
+    int ActionDuration;
+    int NActions;
+    // Batches holding forced strategies or the first random one are started regardless of the deadline
+    std::chrono::high_resolution_clock::time_point Deadline;
+    // No batch is started after it and running ones are dropped, forced strategies included
+    TDeadline HardDeadline{NO_DEADLINE};
+};
+
+// Draws one candidate with the generator of the worker that evaluates it, called from every worker at once
+using TStrategySampler = std::function<TStrategy(std::mt19937& random)>;
+
+struct TEvaluationResult {
+    std::optional<TEvaluatedStrategy> Best;
+    int ForcedEvaluated{0};
+    int RandomEvaluated{0};
+};
+
+class TEvaluationPool {
+public:
+    // nWorkers == 0 means one worker per hardware thread; worker 0 runs on the calling thread
+    explicit TEvaluationPool(int nWorkers = 0);
+    ~TEvaluationPool();
+
+    TEvaluationPool(const TEvaluationPool&) = delete;
+    TEvaluationPool& operator=(const TEvaluationPool&) = delete;
+
+    int Size() const;
+
+    // Resets every worker rollout to the world and reseeds worker generators from seed
+    void SetWorld(const TWorld& world, uint64_t seed);
+
+    // Job i runs on worker i % Size(), jobs of one worker run in increasing order
+    void ParallelFor(int nJobs, const TEvaluationJob& job);
+
+    // Evaluates forced strategies followed by random ones and reduces them to the best score,
+    // ties are broken by the lowest candidate index. Candidates are emulated BATCH_SIZE at a time,
+    // the deadline is checked between batches and the hard deadline between ticks. Candidates of an interrupted
+    // batch are neither counted nor reduced, so the best one is always fully emulated
+    TEvaluationResult Evaluate(const TEvaluationRequest& request);
+
+    // Scores up to count candidates drawn by sample, batches after the deadline are skipped and batches
+    // interrupted by the hard deadline are dropped.
+    // Returns every evaluated candidate from the best one, ties are broken by the lowest candidate index
+    std::vector<TEvaluatedStrategy> EvaluateSampled(int count, const TStrategySampler& sample, int unitId, int untilTick,
+                                                    std::chrono::high_resolution_clock::time_point deadline,
+                                                    TDeadline hardDeadline = NO_DEADLINE);
+
+    // Scores every strategy, result i belongs to strategies[i] and is empty if the hard deadline came first
+    std::vector<std::optional<TScore>> EvaluateAll(const std::vector<TStrategy>& strategies, int unitId, int untilTick,
+                                                   TDeadline hardDeadline = NO_DEADLINE);
+
+    // Same as EvaluateAll, but strategies are emulated one by one through the workers' prefix caches.
+    // Pays off for strategies sharing their first actions, like mutations of one strategy.
+    // Strategies are not started after the deadline, their results stay empty like interrupted ones
+    std::vector<std::optional<TScore>> EvaluateCached(const std::vector<TStrategy>& strategies, int unitId, int untilTick,
+                                                      std::chrono::high_resolution_clock::time_point deadline,
+                                                      TDeadline hardDeadline = NO_DEADLINE);
+
+private:
+    void WorkerLoop(int workerIndex);
+    void RunJobs(TEvaluationWorker& worker);
+
+    std::vector<TEvaluationWorker> Workers_;
+    std::vector<std::thread> Threads_;
+
+    std::mutex Mutex_;
+    std::condition_variable WakeUp_;
+    std::condition_variable Done_;
+    const TEvaluationJob* Job_{nullptr};
+    int NJobs_{0};
+    int Generation_{0};
+    int Pending_{0};
+    bool Stopping_{false};
+};
+
+}
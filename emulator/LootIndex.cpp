@@ -0,0 +1,46 @@
+#include "LootIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Emulator {
+
+// about one loot per cell, but never cells smaller than a unit
+constexpr double MIN_LOOT_CELL_SIZE = 2;
+
+void TLootIndex::Build(std::span<const TIndexedLoot> loot) {
+    Clear();
+    if (loot.empty()) {
+        return;
+    }
+
+    TBoundingBox box(loot[0].Position);
+    for (const auto& item: loot) {
+        box.Add(item.Position);
+    }
+    auto area = std::max(box.Max.x - box.Min.x, MIN_LOOT_CELL_SIZE) * std::max(box.Max.y - box.Min.y, MIN_LOOT_CELL_SIZE);
+    Grid_ = TUniformGrid::Cover(box, std::max(MIN_LOOT_CELL_SIZE, std::sqrt(area / static_cast<double>(loot.size()))));
+
+    // counting sort by cell, every cell keeps the build order
+    CellOffsets_.assign(Grid_.Size() + 1, 0);
+    for (const auto& item: loot) {
+        ++CellOffsets_[Grid_.ToClampedCell(item.Position) + 1];
+    }
+    for (int cell = 0; cell < Grid_.Size(); ++cell) {
+        CellOffsets_[cell + 1] += CellOffsets_[cell];
+    }
+
+    Entries_.resize(loot.size());
+    std::vector<int> cellEnds(CellOffsets_.begin(), CellOffsets_.end() - 1);
+    for (int order = 0; order < static_cast<int>(loot.size()); ++order) {
+        Entries_[cellEnds[Grid_.ToClampedCell(loot[order].Position)]++] = {loot[order].Position, loot[order].LootId, order};
+    }
+}
+
+void TLootIndex::Clear() {
+    Grid_ = {};
+    CellOffsets_.clear();
+    Entries_.clear();
+}
+
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "UniformGrid.h"
+#include "Vector2D.h"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace Emulator {
+
+struct TIndexedLoot {
+    int LootId;
+    Vector2D Position;
+};
+
+// Loot ids of one item type bucketed into a uniform grid, cells are stored CSR-style like in TObstacleMeta.
+// The build order is remembered, so FindNearest breaks distance ties the same way a linear scan would.
+class TLootIndex {
+public:
+    void Build(std::span<const TIndexedLoot> loot);
+    void Clear();
+
+    [[nodiscard]] bool Empty() const { return Entries_.empty(); }
+
+    // Nearest loot accepted by accept(lootId) that is strictly closer than minDist2, which is updated on success;
+    // equally close loot goes to the one built first.
+    // Cells are visited in rings around the point, accept is asked only about loot that would improve the answer.
+    template <typename TAccept>
+    std::optional<int> FindNearest(Vector2D point, std::optional<double>& minDist2, TAccept&& accept) const {
+        return FindNearest(point, minDist2, accept, [point](int, Vector2D position) { return abs2(position - point); });
+    }
+
+    // Same with squared distances given by distance2(lootId, position), which must not be less than the straight ones
+    template <typename TAccept, typename TDistance2>
+    std::optional<int> FindNearest(Vector2D point, std::optional<double>& minDist2, TAccept&& accept, TDistance2&& distance2) const;
+
+private:
+    struct TEntry {
+        Vector2D Position;
+        int LootId;
+        int Order;
+    };
+
+    TUniformGrid Grid_;
+    std::vector<int> CellOffsets_;
+    std::vector<TEntry> Entries_;
+};
+
+template <typename TAccept, typename TDistance2>
+std::optional<int> TLootIndex::FindNearest(Vector2D point, std::optional<double>& minDist2, TAccept&& accept, TDistance2&& distance2) const {
+    if (Entries_.empty()) {
+        return std::nullopt;
+    }
+
+    std::optional<int> output;
+    int outputOrder = 0;
+    auto visitCell = [&](int x, int y) {
+        int cell = y * Grid_.Width + x;
+        for (int i = CellOffsets_[cell]; i < CellOffsets_[cell + 1]; ++i) {
+            const auto& entry = Entries_[i];
+            auto straightDist2 = abs2(entry.Position - point);
+            if (minDist2 && straightDist2 > *minDist2) {
+                continue;
+            }
+            auto dist2 = std::max(straightDist2, distance2(entry.LootId, entry.Position));
+            if (minDist2 && (dist2 > *minDist2 || (dist2 == *minDist2 && !(output && entry.Order < outputOrder)))) {
+                continue;
+            }
+            if (!accept(entry.LootId)) {
+                continue;
+            }
+            minDist2 = dist2;
+            output = entry.LootId;
+            outputOrder = entry.Order;
+        }
+    };
+
+    // cell coordinates may lie outside of the grid, rings that miss it entirely are skipped
+    auto cellX = Grid_.CellX(point.x);
+    auto cellY = Grid_.CellY(point.y);
+    auto width = Grid_.Width;
+    auto height = Grid_.Height;
+    int firstRing = std::max({0, -cellX, cellX - (width - 1), -cellY, cellY - (height - 1)});
+    int lastRing = std::max({cellX, width - 1 - cellX, cellY, height - 1 - cellY});
+    for (int ring = firstRing; ring <= lastRing; ++ring) {
+        // every cell of the ring is at least ring - 1 whole cells away from the point along some axis
+        auto bound = std::max(0, ring - 1) * Grid_.CellSize;
+        if (minDist2 && *minDist2 < bound * bound) {
+            break;
+        }
+        int minY = std::max(0, cellY - ring);
+        int maxY = std::min(height - 1, cellY + ring);
+        int minX = std::max(0, cellX - ring);
+        int maxX = std::min(width - 1, cellX + ring);
+        for (int y = minY; y <= maxY; ++y) {
+            if (y == cellY - ring || y == cellY + ring) {
+                for (int x = minX; x <= maxX; ++x) {
+                    visitCell(x, y);
+                }
+                continue;
+            }
+            if (cellX - ring >= 0 && cellX - ring < width) {
+                visitCell(cellX - ring, y);
+            }
+            if (ring > 0 && cellX + ring >= 0 && cellX + ring < width) {
+                visitCell(cellX + ring, y);
+            }
+        }
+    }
+    return output;
+}
+
+}
@@ -1,13 +1,16 @@
 #include "LootPicker.h"
 #include <cassert>
+#include <cmath>
+#include <limits>
 
 #include "World.h"
 #include "Evaluation.h"
+#include "Navigation.h"
 
 namespace Emulator {
 
 bool LootIsAcceptable(const TWorld &world, const TUnit& unit, int lootId, bool forSimulation) {
-    const auto& loot = world.LootById.find(lootId)->second;
+    const auto& loot = world.Loot.Get(lootId);
     if (abs(loot.Position - world.Zone.currentCenter) > world.Zone.currentRadius - 4) {
         return false;
     }
@@ -28,51 +31,41 @@ std::optional<int> GetTargetLoot(const TWorld &world, int unitId, bool forSimula
     static auto constants = GetGlobalConstants();
     assert(constants);
 
-    auto& unit = world.UnitById.find(unitId)->second;
+    auto& unit = world.Units.Get(unitId);
 
     std::optional<double> minDist2 = std::nullopt;
     std::optional<int> output = std::nullopt;
 
+    auto accept = [&](int lootId) {
+        return LootIsAcceptable(world, unit, lootId, forSimulation);
+    };
+
+    // loot is ranked by the walk around obstacles, the field is kept while the unit stays in its cell
+    static thread_local robin_hood::unordered_node_map<int, TTravelField> travelFieldByUnitId;
+    auto& travelField = travelFieldByUnitId[unitId];
+    travelField.Reset(GetGlobalNavigationGrid(), unit.Position);
+    auto travelDist2 = [&](int, Vector2D position) {
+        // loot further than the best one found loses anyway, its exact distance is not needed
+        auto distance = travelField.GetDistance(position, minDist2 ? std::sqrt(*minDist2) : std::numeric_limits<double>::infinity());
+        return distance * distance;
+    };
+
     if (unit.Weapon != 2) {
-        for (auto& loot: world.LootByItemIndex.find(Weapon)->second) {
-            if (!LootIsAcceptable(world, unit, loot.Id, forSimulation)) {
-                continue;
-            }
-            auto dist2 = abs2(loot.Position - unit.Position);
-            if (!minDist2 || dist2 < minDist2) {
-                minDist2 = dist2;
-                output = loot.Id;
-            }
-        }
+        output = world.LootIndexByItem[Weapon].FindNearest(unit.Position, minDist2, accept, travelDist2);
     }
 
     if (output) {
         return output;
     }
 
+    // ammo and potions compete by distance, on a tie the ammo found first stays
     if (unit.Ammo[2] < constants->weapons[2].maxInventoryAmmo) {
-        for (auto& loot: world.LootByItemIndex.find(Ammo)->second) {
-            if (!LootIsAcceptable(world, unit, loot.Id, forSimulation)) {
-                continue;
-            }
-            auto dist2 = abs2(loot.Position - unit.Position);
-            if (!minDist2 || dist2 < minDist2) {
-                minDist2 = dist2;
-                output = loot.Id;
-            }
-        }
+        output = world.LootIndexByItem[Ammo].FindNearest(unit.Position, minDist2, accept, travelDist2);
     }
 
     if (unit.ShieldPotions < constants->maxShieldPotionsInInventory) {
-        for (auto& loot: world.LootByItemIndex.find(ShieldPotions)->second) {
-            if (!LootIsAcceptable(world, unit, loot.Id, forSimulation)) {
-                continue;
-            }
-            auto dist2 = abs2(loot.Position - unit.Position);
-            if (!minDist2 || dist2 < minDist2) {
-                minDist2 = dist2;
-                output = loot.Id;
-            }
+        if (auto potion = world.LootIndexByItem[ShieldPotions].FindNearest(unit.Position, minDist2, accept, travelDist2)) {
+            output = potion;
         }
     }
 
@@ -81,7 +74,7 @@ std::optional<int> GetTargetLoot(const TWorld &world, int unitId, bool forSimula
 
 Vector2D GetTarget(int unitId, const TWorld &world, std::optional<int> loot) {
     if (loot) {
-        return world.LootById.find(*loot)->second.Position;
+        return world.Loot.Get(*loot).Position;
     } else {
         auto angle = world.StateByUnitId.find(unitId)->second.spiralAngle;
         return world.Zone.nextCenter + Vector2D{cos(angle), sin(angle)} * (0.75 * world.Zone.nextRadius);
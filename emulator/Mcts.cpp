@@ -0,0 +1,282 @@
+#include "Mcts.h"
+#include "Constants.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace Emulator {
+
+// standing still and max forward speed in 8 directions
+constexpr int MCTS_CHOICES = 9;
+constexpr int MAX_MCTS_NODES = 2048;
+constexpr double MCTS_EXPLORATION = 0.5;
+constexpr double MCTS_DECAY = 0.5;
+// executed speeds further than this share of the max speed from every choice match none of them
+constexpr double MCTS_MATCH_DISTANCE = 0.5;
+
+Vector2D GetChoiceSpeed(int choice) {
+    if (choice == 0) {
+        return {0, 0};
+    }
+    auto angle = (choice - 1) * M_PI / 4;
+    return Vector2D{cos(angle), sin(angle)} * GetGlobalConstants()->maxUnitForwardSpeed;
+}
+
+void TMctsTree::Reset(int slotStart) {
+    SlotStart_ = slotStart;
+    Nodes_.clear();
+    Nodes_.reserve(MAX_MCTS_NODES);
+    Nodes_.emplace_back();
+}
+
+void TMctsTree::Prepare(int currentTick, int actionDuration, const std::optional<TMctsExecutedAction>& executed) {
+    if (Nodes_.empty() || ActionDuration_ != actionDuration || SlotStart_ > currentTick) {
+        ActionDuration_ = actionDuration;
+        Reset(currentTick);
+    }
+
+    while (SlotStart_ + ActionDuration_ <= currentTick) {
+        int executedChild = FindExecutedChild(executed);
+        if (executedChild == -1) {
+            Reset(currentTick);
+            break;
+        }
+        Reroot(executedChild);
+        SlotStart_ += ActionDuration_;
+    }
+
+    for (auto& node: Nodes_) {
+        node.Visits *= MCTS_DECAY;
+        node.TotalReward *= MCTS_DECAY;
+    }
+    // the world is new, so are the scores
+    ++Generation_;
+    Scores_.clear();
+}
+
+int TMctsTree::FindExecutedChild(const std::optional<TMctsExecutedAction>& executed) const {
+    const auto& root = Nodes_[0];
+    if (root.FirstChild == -1 || !executed || executed->Tick < SlotStart_ || executed->Tick >= SlotStart_ + ActionDuration_) {
+        return -1;
+    }
+
+    int nearest = 0;
+    for (int choice = 1; choice < MCTS_CHOICES; ++choice) {
+        if (abs(GetChoiceSpeed(choice) - executed->Speed) < abs(GetChoiceSpeed(nearest) - executed->Speed)) {
+            nearest = choice;
+        }
+    }
+    if (abs(GetChoiceSpeed(nearest) - executed->Speed) > MCTS_MATCH_DISTANCE * GetGlobalConstants()->maxUnitForwardSpeed) {
+        return -1;
+    }
+    // children are expanded in choice order and re-rooting keeps it
+    return root.FirstChild + nearest;
+}
+
+// Copies the subtree of child to the front, breadth first so children blocks stay consecutive
+void TMctsTree::Reroot(int child) {
+    std::vector<TMctsNode> nodes;
+    nodes.reserve(MAX_MCTS_NODES);
+    nodes.push_back(std::move(Nodes_[child]));
+    nodes[0].Parent = -1;
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        auto& node = nodes[i];
+        node.Depth = static_cast<int>(i == 0 ? 0 : nodes[node.Parent].Depth + 1);
+        if (node.FirstChild == -1) {
+            continue;
+        }
+        int firstChild = node.FirstChild;
+        node.FirstChild = static_cast<int>(nodes.size());
+        for (int source = firstChild; source < firstChild + MCTS_CHOICES; ++source) {
+            nodes.push_back(std::move(Nodes_[source]));
+            nodes.back().Parent = static_cast<int>(i);
+        }
+    }
+
+    Nodes_ = std::move(nodes);
+}
+
+void TMctsTree::Expand(int node) {
+    assert(Nodes_[node].FirstChild == -1);
+    Nodes_[node].FirstChild = static_cast<int>(Nodes_.size());
+    for (int choice = 0; choice < MCTS_CHOICES; ++choice) {
+        auto& child = Nodes_.emplace_back();
+        child.Parent = node;
+        child.Depth = Nodes_[node].Depth + 1;
+        child.Choice = choice;
+    }
+}
+
+int TMctsTree::SelectChild(int node, std::mt19937& random) const {
+    const auto& parent = Nodes_[node];
+
+    // unvisited children first, from a random one so workers spread over different branches
+    int offset = static_cast<int>(random() % MCTS_CHOICES);
+    for (int i = 0; i < MCTS_CHOICES; ++i) {
+        int child = parent.FirstChild + (offset + i) % MCTS_CHOICES;
+        if (Nodes_[child].Visits == 0) {
+            return child;
+        }
+    }
+
+    int best = -1;
+    double bestValue = 0;
+    auto logVisits = std::log(std::max(parent.Visits, 1.0));
+    for (int child = parent.FirstChild; child < parent.FirstChild + MCTS_CHOICES; ++child) {
+        const auto& candidate = Nodes_[child];
+        auto value = candidate.TotalReward / candidate.Visits + MCTS_EXPLORATION * std::sqrt(logVisits / candidate.Visits);
+        if (best == -1 || value > bestValue) {
+            best = child;
+            bestValue = value;
+        }
+    }
+    return best;
+}
+
+TStrategy TMctsTree::MakeStrategy(const std::vector<int>& choices) const {
+    std::vector<TStrategyAction> actions;
+    actions.reserve(choices.size());
+    for (auto choice: choices) {
+        actions.push_back({
+            .Speed = GetChoiceSpeed(choice),
+            .ActionDuration = ActionDuration_,
+        });
+    }
+    return {
+        .StartTick = SlotStart_,
+        .Actions = std::move(actions),
+    };
+}
+
+double TMctsTree::Rank(const TScore& score) {
+    auto position = std::upper_bound(Scores_.begin(), Scores_.end(), score);
+    double rank = Scores_.empty() ? 0.5 : static_cast<double>(Scores_.end() - position) / Scores_.size();
+    Scores_.insert(position, score);
+    return rank;
+}
+
+TMctsResult TMctsTree::Search(TRollout& rollout, std::mt19937& random, const TMctsRequest& request) {
+    const auto& root = rollout.Root();
+    auto& world = rollout.World();
+    // the last slot may be cut by UntilTick
+    int depthLimit = (request.UntilTick - SlotStart_ + ActionDuration_ - 1) / ActionDuration_;
+    auto endTick = [&](int depth) {
+        return std::min(SlotStart_ + depth * ActionDuration_, request.UntilTick);
+    };
+
+    TMctsResult result;
+    std::vector<int> path;
+    std::vector<int> choices;
+    for (; result.Iterations < request.Iterations; ++result.Iterations) {
+        if (result.Iterations > 0 && std::chrono::high_resolution_clock::now() > request.Deadline) {
+            break;
+        }
+
+        // selection, stops at the first node that has no world yet
+        path.assign(1, 0);
+        choices.clear();
+        int node = 0;
+        bool emulated = false;
+        bool interrupted = false;
+        while (Nodes_[node].Depth < depthLimit) {
+            if (Nodes_[node].FirstChild == -1) {
+                if (static_cast<int>(Nodes_.size()) + MCTS_CHOICES > MAX_MCTS_NODES) {
+                    break;
+                }
+                Expand(node);
+            }
+            int child = SelectChild(node, random);
+            path.push_back(child);
+            choices.push_back(Nodes_[child].Choice);
+            if (Nodes_[child].CheckpointGeneration != Generation_) {
+                // expansion, the world of the parent is replayed with the child's action
+                if (node == 0) {
+                    rollout.Rewind();
+                } else {
+                    world.RestoreCheckpoint(Nodes_[node].Checkpoint);
+                }
+                auto score = node == 0 ? TScore{0, {std::nullopt}, 0} : Nodes_[node].PrefixScore;
+                if (!EmulateStrategy(MakeStrategy(choices), world, root, request.UnitId, endTick(Nodes_[child].Depth), score,
+                                     request.HardDeadline)) {
+                    interrupted = true;
+                    break;
+                }
+                auto& emulatedChild = Nodes_[child];
+                world.SaveCheckpoint(emulatedChild.Checkpoint);
+                emulatedChild.PrefixScore = score;
+                emulatedChild.CheckpointGeneration = Generation_;
+                node = child;
+                emulated = true;
+                break;
+            }
+            node = child;
+        }
+        if (interrupted) {
+            break;
+        }
+
+        if (!emulated) {
+            if (node == 0) {
+                rollout.Rewind();
+            } else {
+                world.RestoreCheckpoint(Nodes_[node].Checkpoint);
+            }
+        }
+
+        // simulation, random actions up to the horizon
+        auto score = node == 0 ? TScore{0, {std::nullopt}, 0} : Nodes_[node].PrefixScore;
+        while (static_cast<int>(choices.size()) < depthLimit) {
+            choices.push_back(static_cast<int>(random() % MCTS_CHOICES));
+        }
+        auto strategy = MakeStrategy(choices);
+        if (!EmulateStrategy(strategy, world, root, request.UnitId, request.UntilTick, score, request.HardDeadline)) {
+            break;
+        }
+
+        if (!result.Best || score < result.Best->Score) {
+            result.Best = TEvaluatedStrategy{
+                .Strategy = std::move(strategy),
+                .Score = score,
+                .CandidateIndex = result.Iterations,
+            };
+        }
+
+        auto reward = Rank(score);
+        for (auto visited: path) {
+            Nodes_[visited].Visits += 1;
+            Nodes_[visited].TotalReward += reward;
+        }
+    }
+
+    rollout.Rewind();
+    return result;
+}
+
+TMctsResult TMctsPlanner::Search(TEvaluationPool& pool, const TMctsRequest& request) {
+    Trees_.resize(pool.Size());
+    std::vector<TMctsResult> resultByWorker(pool.Size());
+
+    pool.ParallelFor(pool.Size(), [&](TEvaluationWorker& worker, int) {
+        auto& tree = Trees_[worker.Index];
+        tree.Prepare(worker.Rollout.Root().CurrentTick, request.ActionDuration, Executed_);
+        resultByWorker[worker.Index] = tree.Search(worker.Rollout, worker.Random, request);
+        return true;
+    });
+
+    TMctsResult output;
+    for (auto& result: resultByWorker) {
+        output.Iterations += result.Iterations;
+        if (result.Best && (!output.Best || result.Best->Score < output.Best->Score)) {
+            output.Best = std::move(result.Best);
+        }
+    }
+    return output;
+}
+
+void TMctsPlanner::SetExecuted(const TMctsExecutedAction& executed) {
+    Executed_ = executed;
+}
+
+}
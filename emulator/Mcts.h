@@ -0,0 +1,97 @@
+#pragma once
+
+#include "public.h"
+#include "Evaluation.h"
+#include "EvaluationPool.h"
+#include "Strategy.h"
+#include "World.h"
+
+#include <chrono>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace Emulator {
+
+struct TMctsRequest {
+    int UnitId;
+    int UntilTick;
+    int ActionDuration;
+    // per worker, every iteration emulates one new node and a random continuation of it
+    int Iterations;
+    // no new iterations start after Deadline, the one running at HardDeadline is dropped
+    std::chrono::high_resolution_clock::time_point Deadline;
+    TDeadline HardDeadline{NO_DEADLINE};
+};
+
+struct TMctsResult {
+    std::optional<TEvaluatedStrategy> Best;
+    int Iterations{0};
+};
+
+// Speed the unit was ordered to move with on a tick, the slot it falls in is re-rooted to the matching choice
+struct TMctsExecutedAction {
+    int Tick;
+    Vector2D Speed;
+};
+
+// Node of a tree over action sequences, the children of a node are MCTS_CHOICES consecutive nodes
+struct TMctsNode {
+    int Parent{-1};
+    int FirstChild{-1};
+    // number of actions from the root, the action of a node is its Choice
+    int Depth{0};
+    int Choice{0};
+
+    // decayed when the tree is re-rooted, so statistics of old ticks fade out
+    double Visits{0};
+    double TotalReward{0};
+
+    // world right after the node's action and the score up to it, valid while CheckpointGeneration is current
+    int CheckpointGeneration{-1};
+    TScore PrefixScore;
+    TWorldCheckpoint Checkpoint;
+};
+
+// UCT search over discretized actions of one unit. Inner nodes keep the emulated world, so iterations
+// sharing a prefix emulate it once per tick. Actions are aligned to slots of ActionDuration ticks like
+// TStrategy actions; when a slot is over, the child of the choice nearest to the executed speed becomes the new root
+// and keeps its subtree. The tree starts over if the unit did something no choice is close to.
+class TMctsTree {
+public:
+    void Prepare(int currentTick, int actionDuration, const std::optional<TMctsExecutedAction>& executed);
+    // Grows the tree on the rollout world and rewinds it afterwards
+    TMctsResult Search(TRollout& rollout, std::mt19937& random, const TMctsRequest& request);
+
+private:
+    void Reset(int slotStart);
+    void Reroot(int child);
+    void Expand(int node);
+    // -1 if the executed action is not from the root slot or is far from every choice
+    int FindExecutedChild(const std::optional<TMctsExecutedAction>& executed) const;
+    int SelectChild(int node, std::mt19937& random) const;
+    TStrategy MakeStrategy(const std::vector<int>& choices) const;
+    // Share of the scores seen this tick that are worse than score
+    double Rank(const TScore& score);
+
+    int SlotStart_{0};
+    int ActionDuration_{0};
+    int Generation_{0};
+    std::vector<TMctsNode> Nodes_;
+    // sorted from the best
+    std::vector<TScore> Scores_;
+};
+
+// One tree per pool worker, searched in parallel and reduced to the best sequence found by any of them
+class TMctsPlanner {
+public:
+    TMctsResult Search(TEvaluationPool& pool, const TMctsRequest& request);
+    // The unit's order of this tick, whatever strategy it came from
+    void SetExecuted(const TMctsExecutedAction& executed);
+
+private:
+    std::vector<TMctsTree> Trees_;
+    std::optional<TMctsExecutedAction> Executed_;
+};
+
+}
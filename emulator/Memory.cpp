@@ -16,7 +16,7 @@ void TMemory::Update(const TWorld &world) {
     {
         std::vector<int> idsToErase;
         for (auto& [id, projectile]: ProjectileById) {
-            if (world.ProjectileById.contains(id)) {
+            if (world.Projectiles.Contains(id)) {
                 continue;
             }
             projectile.Position = projectile.Position + projectile.Velocity / constants->realTicksPerSecond;
@@ -28,8 +28,8 @@ void TMemory::Update(const TWorld &world) {
         for (auto& id: idsToErase) {
             ProjectileById.erase(id);
         }
-        for (auto& [id, projectile]: world.ProjectileById) {
-            ProjectileById[id] = projectile;
+        for (auto& projectile: world.Projectiles) {
+            ProjectileById[projectile.Id] = projectile;
         }
     }
 
@@ -40,12 +40,12 @@ void TMemory::Update(const TWorld &world) {
         LootById2.clear();
     }
 
-    for (const auto& [_, loot]: world.LootById) {
+    for (const auto& loot: world.Loot) {
         LootById.insert({loot.Id, loot});
         LootById2.insert({loot.Id, loot});
     }
 
-    for (auto& [_, unit]: world.UnitById) {
+    for (auto& unit: world.Units) {
         if (unit.PlayerId != world.MyId) {
             continue;
         }
@@ -68,44 +68,42 @@ void TMemory::Update(const TWorld &world) {
         }
     }
 
-    for (const auto& [_, unit]: world.UnitById) {
+    for (const auto& unit: world.Units) {
         UnitById[unit.Id] = unit;
     }
 
     for (auto& [_, unit]: UnitById) {
-        if (world.UnitById.contains(unit.Id)) {
+        if (world.Units.Contains(unit.Id)) {
             continue;
         }
         unit.Position = unit.Position + unit.Velocity / constants->realTicksPerSecond;
     }
 
-    for (auto& [id, unit]: world.UnitById) {
+    for (auto& unit: world.Units) {
         if (unit.PlayerId != world.MyId) {
             continue;
         }
-        StateByUnitId.insert({id, TState{.UnitId = id}});
+        StateByUnitId.insert({unit.Id, TState{.UnitId = unit.Id}});
     }
 }
 
 void TMemory::InjectKnowledge(TWorld &world) {
     for (const auto& [id, projectile]: ProjectileById) {
-        if (!world.ProjectileById.contains(id)) {
-            world.ProjectileById[id] = projectile;
-        }
+        world.Projectiles.Insert(projectile);
     }
 
     for (const auto& [_, loot]: LootById) {
-        world.LootById.insert({loot.Id, loot});
+        world.Loot.Insert(loot);
     }
     for (const auto& [_, loot]: LootById2) {
-        world.LootById.insert({loot.Id, loot});
+        world.Loot.Insert(loot);
     }
 
     for (const auto& [_, unit]: UnitById) {
-        if (!world.UnitById.contains(unit.Id)) {
+        if (!world.Units.Contains(unit.Id)) {
             auto newUnit = unit;
             newUnit.Imaginable = true;
-            world.UnitById.insert({unit.Id, newUnit});
+            world.Units.Insert(newUnit);
         }
     }
 
@@ -120,11 +118,11 @@ void TMemory::UpdateSoundKnowledge(TWorld& world, const TSound &sound) {
     }
 
     auto soundProperties = constants->sounds[sound.TypeIndex];
-    auto distToSound2 = abs2(world.UnitById.find(sound.UnitId)->second.Position - sound.Position);
+    auto distToSound2 = abs2(world.Units.Get(sound.UnitId).Position - sound.Position);
 
     for (auto& [_, unit]: UnitById) {
         if (abs2(unit.Position - sound.Position) < std::max(distToSound2 * soundProperties.offset * soundProperties.offset * 2, 8.0)) {
-            if (!world.UnitById.contains(unit.Id)) {
+            if (!world.Units.Contains(unit.Id)) {
                 unit.Position = sound.Position;
             }
             return;
@@ -0,0 +1,154 @@
+#include "Navigation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+
+namespace Emulator {
+
+// cells grow until the grid fits, a field then takes about a megabyte
+constexpr int64_t MAX_NAVIGATION_CELLS = 1 << 16;
+// paths longer than this many straight distances are not searched for, the loot counts as that far
+constexpr double MAX_TRAVEL_DETOUR = 2;
+constexpr double MIN_NAVIGATION_CELL_SIZE = 1;
+
+std::atomic<uint64_t> NavigationGridGeneration{0};
+
+TNavigationGrid::TNavigationGrid(const TConstants& constants): Generation_(++NavigationGridGeneration) {
+    TBoundingBox box(Vector2D{0, 0});
+    box.Add({0, 0}, constants.initialZoneRadius);
+    for (const auto& obstacle: constants.obstacles) {
+        box.Add(obstacle.Center, obstacle.Radius);
+    }
+    Grid_ = TUniformGrid::Fit(box, MIN_NAVIGATION_CELL_SIZE, [](const TUniformGrid& grid) {
+        return static_cast<int64_t>(grid.Width) * grid.Height <= MAX_NAVIGATION_CELLS;
+    });
+
+    // a unit center closer than its radius to an obstacle means a collision
+    Blocked_.assign(static_cast<size_t>(Grid_.Width) * Grid_.Height, false);
+    for (const auto& obstacle: constants.obstacles) {
+        auto reach = obstacle.Radius + constants.unitRadius;
+        auto minX = std::max(0, Grid_.CellX(obstacle.Center.x - reach));
+        auto maxX = std::min(Grid_.Width - 1, Grid_.CellX(obstacle.Center.x + reach));
+        auto minY = std::max(0, Grid_.CellY(obstacle.Center.y - reach));
+        auto maxY = std::min(Grid_.Height - 1, Grid_.CellY(obstacle.Center.y + reach));
+        for (int y = minY; y <= maxY; ++y) {
+            for (int x = minX; x <= maxX; ++x) {
+                if (abs2(Grid_.CellCenter(x, y) - obstacle.Center) < reach * reach) {
+                    Blocked_[y * Grid_.Width + x] = true;
+                }
+            }
+        }
+    }
+}
+
+std::unique_ptr<TNavigationGrid> GlobalNavigationGrid;
+
+void BuildGlobalNavigationGrid() {
+    assert(GetGlobalConstants());
+    GlobalNavigationGrid = std::make_unique<TNavigationGrid>(*GetGlobalConstants());
+}
+
+const TNavigationGrid* GetGlobalNavigationGrid() {
+    return GlobalNavigationGrid.get();
+}
+
+void TTravelField::Reset(const TNavigationGrid* grid, Vector2D source) {
+    auto sourceCell = grid ? grid->ToCell(source) : -1;
+    Source_ = source;
+    if (grid == Grid_ && grid && grid->Generation() == Generation_ && sourceCell == SourceCell_) {
+        return;
+    }
+
+    Grid_ = grid;
+    Generation_ = grid ? grid->Generation() : 0;
+    SourceCell_ = sourceCell;
+    Frontier_ = {};
+    if (SourceCell_ == -1) {
+        return;
+    }
+
+    auto cells = static_cast<size_t>(grid->Width()) * grid->Height();
+    if (CellStamps_.size() != cells || ++Stamp_ == 0) {
+        CellStamps_.assign(cells, 0);
+        Distances_.resize(cells);
+        Settled_.resize(cells);
+        Stamp_ = 1;
+    }
+    CellStamps_[SourceCell_] = Stamp_;
+    Distances_[SourceCell_] = 0;
+    Settled_[SourceCell_] = false;
+    Frontier_.emplace(0, SourceCell_);
+}
+
+void TTravelField::Expand(int cell, double maxDistance) {
+    static const double diagonal = std::sqrt(2.0);
+    auto width = Grid_->Width();
+    auto height = Grid_->Height();
+
+    while (!Frontier_.empty() && !(CellStamps_[cell] == Stamp_ && Settled_[cell])) {
+        auto [distance, current] = Frontier_.top();
+        if (distance > maxDistance) {
+            break;
+        }
+        Frontier_.pop();
+        if (Settled_[current]) {
+            continue;
+        }
+        Settled_[current] = true;
+        if (current != SourceCell_ && Grid_->IsBlocked(current)) {
+            continue;
+        }
+
+        int x = current % width;
+        int y = current / width;
+        auto passable = [&](int nx, int ny) {
+            return nx >= 0 && nx < width && ny >= 0 && ny < height && !Grid_->IsBlocked(ny * width + nx);
+        };
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                int nx = x + dx;
+                int ny = y + dy;
+                if ((!dx && !dy) || nx < 0 || nx >= width || ny < 0 || ny >= height) {
+                    continue;
+                }
+                // no cutting corners of obstacles
+                if (dx && dy && (!passable(x + dx, y) || !passable(x, y + dy))) {
+                    continue;
+                }
+                int next = ny * width + nx;
+                auto nextDistance = distance + Grid_->CellSize() * (dx && dy ? diagonal : 1);
+                if (CellStamps_[next] != Stamp_) {
+                    CellStamps_[next] = Stamp_;
+                    Settled_[next] = false;
+                } else if (Settled_[next] || Distances_[next] <= nextDistance) {
+                    continue;
+                }
+                Distances_[next] = nextDistance;
+                Frontier_.emplace(nextDistance, next);
+            }
+        }
+    }
+}
+
+double TTravelField::GetDistance(Vector2D point, double maxDistance) {
+    auto straight = abs(point - Source_);
+    if (SourceCell_ == -1) {
+        return straight;
+    }
+    auto cell = Grid_->ToCell(point);
+    if (cell == -1) {
+        return straight;
+    }
+
+    // the grid walks from cell centers, leave some slack for the cells the points are in
+    auto detour = MAX_TRAVEL_DETOUR * straight + 2 * Grid_->CellSize();
+    Expand(cell, std::min(maxDistance, detour));
+    if (CellStamps_[cell] != Stamp_ || !Settled_[cell]) {
+        return detour;
+    }
+    return std::max(straight, Distances_[cell]);
+}
+
+}
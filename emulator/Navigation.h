@@ -0,0 +1,70 @@
+#pragma once
+
+#include "public.h"
+#include "Constants.h"
+#include "UniformGrid.h"
+#include "Vector2D.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace Emulator {
+
+// Cells whose center a unit can not stand on because of an obstacle, over the initial zone and every obstacle
+class TNavigationGrid {
+public:
+    explicit TNavigationGrid(const TConstants& constants);
+
+    // -1 outside of the grid
+    int ToCell(Vector2D point) const { return Grid_.ToCell(point); }
+    Vector2D CellCenter(int cell) const { return Grid_.CellCenter(cell); }
+    bool IsBlocked(int cell) const { return Blocked_[cell]; }
+
+    int Width() const { return Grid_.Width; }
+    int Height() const { return Grid_.Height; }
+    double CellSize() const { return Grid_.CellSize; }
+    // distinguishes grids of different games, addresses may be reused
+    uint64_t Generation() const { return Generation_; }
+
+private:
+    TUniformGrid Grid_;
+    uint64_t Generation_{0};
+    std::vector<uint8_t> Blocked_;
+};
+
+void BuildGlobalNavigationGrid();
+const TNavigationGrid* GetGlobalNavigationGrid();
+
+// Shortest 8-connected path lengths over a navigation grid from the cell of one point, expanded lazily:
+// Dijkstra runs only until the cell asked about is settled, and the frontier is kept for later queries.
+// Blocked cells can be entered but not left, so loot lying next to an obstacle still gets a distance.
+class TTravelField {
+public:
+    // Starts a new field if the point left the source cell or the grid changed, otherwise keeps the settled cells
+    void Reset(const TNavigationGrid* grid, Vector2D source);
+
+    // Never less than the straight distance, which is returned where the grid does not cover the points.
+    // Paths longer than a few straight distances count as that long; if that is more than maxDistance,
+    // the answer is only guaranteed to be more than maxDistance.
+    double GetDistance(Vector2D point, double maxDistance = std::numeric_limits<double>::infinity());
+
+private:
+    void Expand(int cell, double maxDistance);
+
+    const TNavigationGrid* Grid_{nullptr};
+    uint64_t Generation_{0};
+    Vector2D Source_{0, 0};
+    int SourceCell_{-1};
+
+    // cells stamped with an older Stamp_ are untouched in this field
+    uint32_t Stamp_{0};
+    std::vector<uint32_t> CellStamps_;
+    std::vector<double> Distances_;
+    std::vector<uint8_t> Settled_;
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> Frontier_;
+};
+
+}
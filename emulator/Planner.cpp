@@ -0,0 +1,93 @@
+#include "Planner.h"
+#include "Constants.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace Emulator {
+
+// share of the refitted distribution in the new one, the rest stays from the old one
+constexpr double CEM_SMOOTHING = 0.7;
+// keeps some exploration around a converged plan, in max forward speeds
+constexpr double CEM_MIN_DEVIATION = 0.05;
+
+// GenerateRandomStrategy draws every component uniformly from this many max forward speeds in both directions
+constexpr double CEM_SPEED_RANGE = 2;
+
+TSpeedDistribution GetWideSpeedDistribution(Vector2D mean) {
+    // deviation of the uniform distribution GenerateRandomStrategy uses
+    auto deviation = CEM_SPEED_RANGE * GetGlobalConstants()->maxUnitForwardSpeed / std::sqrt(3.0);
+    return {
+        .Mean = mean,
+        .Deviation = {deviation, deviation},
+    };
+}
+
+void TCrossEntropyPlanner::Shift(int currentTick, int actionDuration, int nActions) {
+    assert(GetGlobalConstants());
+    if (Actions_.size() != static_cast<size_t>(nActions) || ActionDuration_ != actionDuration || StartTick_ > currentTick) {
+        StartTick_ = currentTick;
+        ActionDuration_ = actionDuration;
+        Actions_.assign(nActions, GetWideSpeedDistribution({0, 0}));
+        return;
+    }
+
+    while (StartTick_ + ActionDuration_ <= currentTick) {
+        // the new last action continues the old one, but is not refined yet
+        auto last = GetWideSpeedDistribution(Actions_.back().Mean);
+        Actions_.erase(Actions_.begin());
+        Actions_.push_back(last);
+        StartTick_ += ActionDuration_;
+    }
+}
+
+TStrategy TCrossEntropyPlanner::Sample(std::mt19937& random) const {
+    auto maxSpeed = CEM_SPEED_RANGE * GetGlobalConstants()->maxUnitForwardSpeed;
+    std::normal_distribution<double> normal;
+
+    std::vector<TStrategyAction> actions;
+    actions.reserve(Actions_.size());
+    for (const auto& action: Actions_) {
+        double x = action.Mean.x + normal(random) * action.Deviation.x;
+        double y = action.Mean.y + normal(random) * action.Deviation.y;
+        actions.push_back({
+            .Speed = {std::clamp(x, -maxSpeed, maxSpeed), std::clamp(y, -maxSpeed, maxSpeed)},
+            .ActionDuration = ActionDuration_,
+        });
+    }
+
+    return {
+        .StartTick = StartTick_,
+        .Actions = std::move(actions),
+    };
+}
+
+void TCrossEntropyPlanner::Refit(const std::vector<const TStrategy*>& elites) {
+    if (elites.empty()) {
+        return;
+    }
+    auto minDeviation = CEM_MIN_DEVIATION * GetGlobalConstants()->maxUnitForwardSpeed;
+
+    for (size_t i = 0; i < Actions_.size(); ++i) {
+        Vector2D mean{0, 0};
+        for (const auto* elite: elites) {
+            assert(elite->StartTick == StartTick_ && elite->Actions.size() == Actions_.size());
+            mean = mean + elite->Actions[i].Speed * (1.0 / elites.size());
+        }
+        Vector2D variance{0, 0};
+        for (const auto* elite: elites) {
+            auto delta = elite->Actions[i].Speed - mean;
+            variance = variance + Vector2D{delta.x * delta.x, delta.y * delta.y} * (1.0 / elites.size());
+        }
+
+        auto& action = Actions_[i];
+        action.Mean = mean * CEM_SMOOTHING + action.Mean * (1 - CEM_SMOOTHING);
+        action.Deviation = {
+            std::max(minDeviation, std::sqrt(variance.x) * CEM_SMOOTHING + action.Deviation.x * (1 - CEM_SMOOTHING)),
+            std::max(minDeviation, std::sqrt(variance.y) * CEM_SMOOTHING + action.Deviation.y * (1 - CEM_SMOOTHING)),
+        };
+    }
+}
+
+}
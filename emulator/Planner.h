@@ -0,0 +1,39 @@
+#pragma once
+
+#include "public.h"
+#include "Strategy.h"
+#include "Vector2D.h"
+
+#include <random>
+#include <vector>
+
+namespace Emulator {
+
+// Independent gaussians over both speed components of one action
+struct TSpeedDistribution {
+    Vector2D Mean;
+    Vector2D Deviation;
+};
+
+// Cross-entropy method over the action speeds of a unit's strategy: samples are drawn from the distribution,
+// which is then refitted to the best of them. The distribution lives across ticks, Shift keeps it aligned
+// with the current tick, so the refinement of one tick is the starting point of the next.
+class TCrossEntropyPlanner {
+public:
+    // Drops the actions that are over by currentTick and appends wide ones, so the plan keeps nActions actions.
+    // Starts from scratch if the timing does not match the previous call
+    void Shift(int currentTick, int actionDuration, int nActions);
+
+    // Thread safe, the planner is not changed
+    TStrategy Sample(std::mt19937& random) const;
+
+    // Moves the distribution towards the elites, which have to be drawn by Sample after the last Shift
+    void Refit(const std::vector<const TStrategy*>& elites);
+
+private:
+    int StartTick_{0};
+    int ActionDuration_{0};
+    std::vector<TSpeedDistribution> Actions_;
+};
+
+}
@@ -0,0 +1,128 @@
+#include "PrefixCache.h"
+
+#include <bit>
+#include <cassert>
+
+namespace Emulator {
+
+// a few strategies with five actions each, the worlds are copied out on every hit
+constexpr int MAX_PREFIX_CACHE_ENTRIES = 64;
+
+void TPrefixCache::Clear() {
+    Entries_.clear();
+    EntryByKey_.clear();
+}
+
+uint64_t TPrefixCache::GetKey(const TStrategy& strategy, int unitId, int prefixLength) {
+    uint64_t key = 14695981039346656037ull;
+    auto mix = [&key](uint64_t value) {
+        key = (key ^ value) * 1099511628211ull;
+    };
+    mix(static_cast<uint64_t>(unitId));
+    mix(static_cast<uint64_t>(strategy.StartTick));
+    mix(static_cast<uint64_t>(strategy.ObedienceLevel));
+    mix(static_cast<uint64_t>(prefixLength));
+    for (int i = 0; i < prefixLength; ++i) {
+        const auto& action = strategy.Actions[i];
+        mix(std::bit_cast<uint64_t>(action.Speed.x));
+        mix(std::bit_cast<uint64_t>(action.Speed.y));
+        mix(static_cast<uint64_t>(action.ActionDuration));
+    }
+    return key;
+}
+
+int TPrefixCache::Find(const TStrategy& strategy, int unitId, int prefixLength) const {
+    auto it = EntryByKey_.find(GetKey(strategy, unitId, prefixLength));
+    if (it == EntryByKey_.end()) {
+        return -1;
+    }
+
+    const auto& entry = Entries_[it->second];
+    if (entry.UnitId != unitId || entry.StartTick != strategy.StartTick || entry.ObedienceLevel != strategy.ObedienceLevel
+        || static_cast<int>(entry.Prefix.size()) != prefixLength) {
+        return -1;
+    }
+    for (int i = 0; i < prefixLength; ++i) {
+        const auto& cached = entry.Prefix[i];
+        const auto& action = strategy.Actions[i];
+        if (cached.Speed.x != action.Speed.x || cached.Speed.y != action.Speed.y || cached.ActionDuration != action.ActionDuration) {
+            return -1;
+        }
+    }
+    return it->second;
+}
+
+std::optional<TScore> TPrefixCache::Evaluate(const TStrategy& strategy, TRollout& rollout, int unitId, int untilTick, TDeadline deadline) {
+    const auto& root = rollout.Root();
+    assert(root.StateByUnitId.contains(unitId));
+    auto& world = rollout.World();
+
+    auto finish = [&](bool completed, const TScore& score) -> std::optional<TScore> {
+        rollout.Rewind();
+        if (!completed) {
+            return std::nullopt;
+        }
+        return score;
+    };
+
+    // a GoTo strategy has no actions to share
+    if (strategy.GoTo || strategy.Actions.empty()) {
+        TScore score = {0, {std::nullopt}, 0};
+        auto completed = EmulateStrategy(strategy, world, root, unitId, untilTick, score, deadline);
+        return finish(completed, score);
+    }
+
+    // boundaries[k] is the first tick of action k, the last action lasts until untilTick
+    int nActions = static_cast<int>(strategy.Actions.size());
+    std::vector<int> boundaries(nActions);
+    boundaries[0] = strategy.StartTick;
+    for (int k = 1; k < nActions; ++k) {
+        boundaries[k] = boundaries[k - 1] + strategy.Actions[k - 1].ActionDuration;
+    }
+    auto isUseful = [&](int k) {
+        return root.CurrentTick < boundaries[k] && boundaries[k] < untilTick;
+    };
+
+    TScore score = {0, {std::nullopt}, 0};
+    int resumed = 0;
+    for (int k = nActions - 1; k > 0; --k) {
+        if (!isUseful(k)) {
+            continue;
+        }
+        if (auto entry = Find(strategy, unitId, k); entry != -1) {
+            world.RestoreCheckpoint(Entries_[entry].Checkpoint);
+            score = Entries_[entry].Score;
+            resumed = k;
+            break;
+        }
+    }
+
+    for (int k = resumed + 1; k < nActions; ++k) {
+        if (!isUseful(k)) {
+            continue;
+        }
+        if (!EmulateStrategy(strategy, world, root, unitId, boundaries[k], score, deadline)) {
+            return finish(false, score);
+        }
+        if (static_cast<int>(Entries_.size()) >= MAX_PREFIX_CACHE_ENTRIES) {
+            continue;
+        }
+        auto key = GetKey(strategy, unitId, k);
+        if (EntryByKey_.contains(key)) {
+            continue;
+        }
+        EntryByKey_[key] = static_cast<int>(Entries_.size());
+        auto& entry = Entries_.emplace_back(TEntry{
+            .UnitId = unitId,
+            .StartTick = strategy.StartTick,
+            .ObedienceLevel = strategy.ObedienceLevel,
+            .Prefix = {strategy.Actions.begin(), strategy.Actions.begin() + k},
+            .Score = score,
+        });
+        world.SaveCheckpoint(entry.Checkpoint);
+    }
+    auto completed = EmulateStrategy(strategy, world, root, unitId, untilTick, score, deadline);
+    return finish(completed, score);
+}
+
+}
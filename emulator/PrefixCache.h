@@ -0,0 +1,46 @@
+#pragma once
+
+#include "public.h"
+#include "Evaluation.h"
+#include "Strategy.h"
+#include "World.h"
+
+#include "robin_hood.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace Emulator {
+
+// Worlds and scores at the action boundaries of strategies emulated from one rollout root, keyed by the actions
+// before the boundary. A strategy that shares its first actions with an earlier one, like a mutation of a later
+// action, resumes from the deepest cached boundary instead of the root. Clear it whenever the root changes.
+class TPrefixCache {
+public:
+    void Clear();
+
+    // Same score as EvaluateStrategy, rollout is rewound afterwards. Nothing if the deadline interrupted the emulation,
+    // boundaries passed before that stay cached
+    std::optional<TScore> Evaluate(const TStrategy& strategy, TRollout& rollout, int unitId, int untilTick, TDeadline deadline = NO_DEADLINE);
+
+private:
+    struct TEntry {
+        int UnitId;
+        int StartTick;
+        EObedienceLevel ObedienceLevel;
+        std::vector<TStrategyAction> Prefix;
+        TWorldCheckpoint Checkpoint;
+        TScore Score;
+    };
+
+    static uint64_t GetKey(const TStrategy& strategy, int unitId, int prefixLength);
+    // -1 if the prefix is not cached
+    int Find(const TStrategy& strategy, int unitId, int prefixLength) const;
+
+    std::vector<TEntry> Entries_;
+    // entries with colliding keys are not cached
+    robin_hood::unordered_map<uint64_t, int> EntryByKey_;
+};
+
+}
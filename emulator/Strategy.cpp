@@ -4,18 +4,19 @@
 #include "World.h"
 #include "LootPicker.h"
 #include "Evaluation.h"
+#include "Visibility.h"
 
 #include <cassert>
 #include <iostream>
 
 namespace Emulator {
 
-TStrategyAction GenerateRandomAction(int actionDuration) {
+TStrategyAction GenerateRandomAction(int actionDuration, std::mt19937& random) {
     assert(GetGlobalConstants());
 
-    auto speed = RandomUniformVector() * GetGlobalConstants()->maxUnitForwardSpeed * 2;
+    auto speed = RandomUniformVector(random) * GetGlobalConstants()->maxUnitForwardSpeed * 2;
 
-    if (rand() % 20 == 0) {
+    if (random() % 20 == 0) {
         speed = {0, 0};
     }
 
@@ -25,12 +26,12 @@ TStrategyAction GenerateRandomAction(int actionDuration) {
     };
 }
 
-TStrategy GenerateRandomStrategy(int startTick, int actionDuration, int nActions) {
+TStrategy GenerateRandomStrategy(int startTick, int actionDuration, int nActions, std::mt19937& random) {
     std::vector<TStrategyAction> actions;
     actions.reserve(nActions);
 
     for (int i = 0; i < nActions; ++i) {
-        actions.push_back(GenerateRandomAction(actionDuration));
+        actions.push_back(GenerateRandomAction(actionDuration, random));
     }
 
     return {
@@ -66,7 +67,7 @@ TStrategyAction TStrategy::GetAction(const TWorld& world, int unitId, int tickId
     assert(constants);
 
     if (GoTo) {
-        const auto& unit = world.UnitById.find(unitId)->second;
+        const auto& unit = world.Units.Get(unitId);
         if (abs(unit.Position - *GoTo) < constants->unitRadius) {
             return TStrategyAction{
                 .Speed = Vector2D{0, 0},
@@ -111,7 +112,7 @@ TOrder TStrategy::GetResGatheringOrder(const TWorld &world, int unitId, bool for
     auto constants = GetGlobalConstants();
     assert(constants);
     auto action = GetAction(world, unitId, world.CurrentTick);
-    const auto& unit = world.UnitById.find(unitId)->second;
+    const auto& unit = world.Units.Get(unitId);
     assert(world.StateByUnitId.find(unitId) != world.StateByUnitId.end());
     const auto& unitState = world.StateByUnitId.find(unitId)->second;
     bool isRotationStart = (world.CurrentTick - state.LastRotationTick >= constants->realTicksPerSecond * ROTATION_PERIOD);
@@ -155,7 +156,7 @@ TOrder TStrategy::GetOrder(const TWorld &world, int unitId, bool forSimulation)
 
     if (ObedienceLevel == HARD) {
         auto action = GetAction(world, unitId, world.CurrentTick);
-        const auto& unit = world.UnitById.find(unitId)->second;
+        const auto& unit = world.Units.Get(unitId);
 
         return {
             .UnitId = unitId,
@@ -173,7 +174,7 @@ TOrder TStrategy::GetOrder(const TWorld &world, int unitId, bool forSimulation)
 
     auto action = GetAction(world, unitId, world.CurrentTick);
 
-    const auto& unit = world.UnitById.find(unitId)->second;
+    const auto& unit = world.Units.Get(unitId);
 
     assert(world.StateByUnitId.find(unitId) != world.StateByUnitId.end());
     const auto& unitState = world.StateByUnitId.find(unitId)->second;
@@ -195,7 +196,7 @@ TOrder TStrategy::GetOrder(const TWorld &world, int unitId, bool forSimulation)
     {
         std::optional<double> closestDist2;
         int closestUnitId;
-        for (const auto& [_, otherUnit]: world.UnitById) {
+        for (const auto& otherUnit: world.Units) {
             if (otherUnit.Imaginable && abs(otherUnit.Position - unit.Position) > constants->viewDistance) {
                 continue;
             }
@@ -210,7 +211,7 @@ TOrder TStrategy::GetOrder(const TWorld &world, int unitId, bool forSimulation)
             }
         }
         if (closestDist2) {
-            const auto& otherUnit = world.UnitById.find(closestUnitId)->second;
+            const auto& otherUnit = world.Units.Get(closestUnitId);
             auto actionRadius = std::max(otherUnit.GetCombatRadius(), unit.GetCombatRadius());
 
             if (*closestDist2 < actionRadius * actionRadius && unit.Weapon) {
@@ -221,7 +222,7 @@ TOrder TStrategy::GetOrder(const TWorld &world, int unitId, bool forSimulation)
                 bool aim = (world.CurrentTick >= unit.NextShotTick - aimWindow);
 
                 if (shoot && !forSimulation) {
-                    shoot = !constants->obstaclesMeta.SegmentIntersectsObstacle(unit.Position, otherUnit.Position);
+                    shoot = CanShootThrough(unit.Position, otherUnit.Position);
                 }
 
                 if (otherUnit.RemainingSpawnTime > 0) {
@@ -233,15 +234,14 @@ TOrder TStrategy::GetOrder(const TWorld &world, int unitId, bool forSimulation)
                         continue;
                     }
 
-                    assert(world.UnitById.contains(friendId));
-                    const auto& friendUnit = world.UnitById.find(friendId)->second;
+                    const auto& friendUnit = world.Units.Get(friendId);
                     if (SegmentIntersectsCircle(unit.Position, otherUnit.Position, friendUnit.Position, constants->unitRadius)) {
                         shoot = false;
                         break;
                     }
                 }
 
-                auto direction = GetPreventiveTargetDirection(unit, world.UnitById.find(closestUnitId)->second);
+                auto direction = GetPreventiveTargetDirection(unit, world.Units.Get(closestUnitId));
 
                 if (ObedienceLevel == SOFT) {
                     auto fov = constants->fieldOfView;
@@ -249,7 +249,7 @@ TOrder TStrategy::GetOrder(const TWorld &world, int unitId, bool forSimulation)
                         fov -= unit.Aim * (constants->fieldOfView - constants->weapons[*unit.Weapon].aimFieldOfView);
                     }
 
-                    direction = CropDirection(abs(action.Speed) > 0.01 ? norm(action.Speed):direction, world.UnitById.find(closestUnitId)->second.Position - unit.Position, fov / 180 * M_PI / 2 / 3);
+                    direction = CropDirection(abs(action.Speed) > 0.01 ? norm(action.Speed):direction, world.Units.Get(closestUnitId).Position - unit.Position, fov / 180 * M_PI / 2 / 3);
                 }
 
                 return {
@@ -290,26 +290,29 @@ TOrder TStrategy::GetOrder(const TWorld &world, int unitId, bool forSimulation)
 }
 
 
-TStrategy TStrategy::Mutate() {
+TStrategy TStrategy::Mutate(std::mt19937& random) const {
     auto output = *this;
     if (GoTo) {
         return output;
     }
-    int mutationIndex = (int)(rand() % Actions.size());
+    int mutationIndex = (int)(random() % Actions.size());
 
-    output.Actions[mutationIndex].Speed = output.Actions[mutationIndex].Speed + RandomUniformVector() * GetGlobalConstants()->maxUnitForwardSpeed * 0.2;
+    output.Actions[mutationIndex].Speed = output.Actions[mutationIndex].Speed + RandomUniformVector(random) * GetGlobalConstants()->maxUnitForwardSpeed * 0.2;
     return output;
 }
 
-void VisualiseStrategy(const TStrategy& strategy, const TWorld &world, int unitId, int untilTick) {
-    TWorld currentWorld = world;
-    auto& unit = currentWorld.UnitById[unitId];
+#ifdef DEBUG_VISUALISATION
+void VisualiseStrategy(const TStrategy& strategy, TRollout& rollout, int unitId, int untilTick) {
+    const auto& world = rollout.Root();
+    auto& currentWorld = rollout.World();
+    auto& unit = currentWorld.Units.Get(unitId);
 
     std::vector<model::Vec2> line;
     line.reserve(untilTick - currentWorld.CurrentTick);
 
     while (currentWorld.CurrentTick < untilTick) {
         currentWorld.PrepareEmulation();
+        currentWorld.EmulateTeammates(unitId);
         currentWorld.EmulateOrder(strategy.GetOrder(currentWorld, unitId));
         currentWorld.Tick();
         line.push_back(unit.Position.ToApi());
@@ -323,16 +326,19 @@ void VisualiseStrategy(const TStrategy& strategy, const TWorld &world, int unitI
                 color = debugging::Color(1, 0, 0, 1);
             }
         }
-        GetGlobalDebugInterface()->addCircle(unit.Position.ToApi(), 0.1, color);
+        DEBUG_DRAW(addCircle(unit.Position.ToApi(), 0.1, color));
 
-        for (auto& [_, projectile]: currentWorld.ProjectileById) {
-            GetGlobalDebugInterface()->addCircle(projectile.Position.ToApi(), 0.1, debugging::Color(0, 1, 0, 1));
+        for (auto& projectile: currentWorld.Projectiles) {
+            DEBUG_DRAW(addCircle(projectile.Position.ToApi(), 0.1, debugging::Color(0, 1, 0, 1)));
         }
     }
 
+    rollout.Rewind();
+
     assert(GetGlobalDebugInterface());
-//    GetGlobalDebugInterface()->addPolyLine(std::move(line), 0.15, debugging::Color(1, 0, 0, 1));
+//    DEBUG_DRAW(addPolyLine(std::move(line), 0.15, debugging::Color(1, 0, 0, 1)));
 }
+#endif
 
 TStrategy GenerateRunaway(Vector2D direction) {
     auto constants = GetGlobalConstants();
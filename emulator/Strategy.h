@@ -3,8 +3,9 @@
 #include "public.h"
 #include "Vector2D.h"
 
-#include <vector>
 #include <optional>
+#include <random>
+#include <vector>
 
 namespace Emulator {
 
@@ -28,7 +29,8 @@ struct TStrategy {
     std::optional<Vector2D> GoTo;
 
     [[nodiscard]] TOrder GetOrder(const TWorld& world, int unitId, bool forSimulation = true) const;
-    TStrategy Mutate();
+    // Shifts the speed of one random action, the actions before it stay the same
+    TStrategy Mutate(std::mt19937& random) const;
 
     TStrategyAction GetAction(const TWorld& world, int unitId, int tickId) const;
     TOrder GetResGatheringOrder(const TWorld& world, int unitId, bool forSimulation = true) const;
@@ -36,10 +38,15 @@ struct TStrategy {
     EObedienceLevel ObedienceLevel{DEFAULT};
 };
 
-TStrategy GenerateRandomStrategy(int startTick, int actionDuration, int nActions);
+TStrategy GenerateRandomStrategy(int startTick, int actionDuration, int nActions, std::mt19937& random);
 
 TStrategy GenerateRunaway(Vector2D direction);
 
-void VisualiseStrategy(const TStrategy& strategy, const TWorld &world, int unitId, int untilTick);
+#ifdef DEBUG_VISUALISATION
+void VisualiseStrategy(const TStrategy& strategy, TRollout& rollout, int unitId, int untilTick);
+#else
+// Production builds do not emulate anything for visualisation
+inline void VisualiseStrategy(const TStrategy&, TRollout&, int, int) {}
+#endif
 
 }
@@ -0,0 +1,120 @@
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace Emulator {
+
+void TLatencyHistogram::Add(int64_t microseconds) {
+    microseconds = std::max<int64_t>(microseconds, 0);
+    auto bucket = std::min<int64_t>(microseconds / LATENCY_BUCKET_MICROSECONDS, LATENCY_BUCKETS - 1);
+    ++Buckets_[bucket];
+    ++Count_;
+    Max_ = std::max(Max_, microseconds);
+}
+
+int64_t TLatencyHistogram::Count() const {
+    return Count_;
+}
+
+int64_t TLatencyHistogram::Percentile(double fraction) const {
+    if (!Count_) {
+        return 0;
+    }
+
+    auto rank = std::max<int64_t>(1, static_cast<int64_t>(std::ceil(fraction * Count_)));
+    int64_t seen = 0;
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; ++bucket) {
+        seen += Buckets_[bucket];
+        if (seen >= rank) {
+            // the last bucket has no upper bound but the maximum
+            if (bucket == LATENCY_BUCKETS - 1) {
+                return Max_;
+            }
+            return std::min(Max_, (bucket + 1) * LATENCY_BUCKET_MICROSECONDS);
+        }
+    }
+    return Max_;
+}
+
+int64_t TLatencyHistogram::Max() const {
+    return Max_;
+}
+
+void TLatencyHistogram::Print(std::ostream& out) const {
+    out << "count " << Count_
+        << " p50 " << Percentile(0.5) / 1000. << "ms"
+        << " p99 " << Percentile(0.99) / 1000. << "ms"
+        << " max " << Max_ / 1000. << "ms";
+}
+
+TTelemetry::TTelemetry() {
+    if (const char* path = std::getenv("AICUP_TELEMETRY_CSV")) {
+        Csv_ = std::make_unique<std::ofstream>(path);
+        *Csv_ << "tick,unit_id,microseconds,forced_evaluated,random_evaluated,time_resource\n";
+    }
+}
+
+void TTelemetry::AddUnitDecision(const TUnitDecisionTelemetry& decision) {
+    UnitLatency_.Add(decision.Microseconds);
+    UnitLatencyById_[decision.UnitId].Add(decision.Microseconds);
+    ForcedEvaluated_ += decision.ForcedEvaluated;
+    RandomEvaluated_ += decision.RandomEvaluated;
+    if (decision.TimeResource < 0) {
+        ++BudgetOverruns_;
+    }
+
+    if (Csv_) {
+        *Csv_ << decision.Tick << ',' << decision.UnitId << ',' << decision.Microseconds << ','
+              << decision.ForcedEvaluated << ',' << decision.RandomEvaluated << ',' << decision.TimeResource << '\n';
+    }
+}
+
+// Tick rows have unit_id -1 and no evaluation counters
+void TTelemetry::AddTick(int tick, int64_t microseconds) {
+    TickLatency_.Add(microseconds);
+
+    if (Csv_) {
+        *Csv_ << tick << ",-1," << microseconds << ",,,\n";
+    }
+}
+
+void TTelemetry::PrintSummary(std::ostream& out) const {
+    out << "tick latency: ";
+    TickLatency_.Print(out);
+    out << "\nunit latency: ";
+    UnitLatency_.Print(out);
+    out << "\n";
+
+    std::vector<int> unitIds;
+    for (const auto& [unitId, histogram]: UnitLatencyById_) {
+        unitIds.push_back(unitId);
+    }
+    std::sort(unitIds.begin(), unitIds.end());
+    for (auto unitId: unitIds) {
+        out << "  unit " << unitId << ": ";
+        UnitLatencyById_.find(unitId)->second.Print(out);
+        out << "\n";
+    }
+
+    auto decisions = UnitLatency_.Count();
+    out << "strategies evaluated: " << ForcedEvaluated_ + RandomEvaluated_
+        << " (forced " << ForcedEvaluated_ << ", random " << RandomEvaluated_ << ")";
+    if (decisions) {
+        out << ", " << (ForcedEvaluated_ + RandomEvaluated_) / decisions << " per decision";
+    }
+    out << "\nbudget overruns: " << BudgetOverruns_ << " of " << decisions << " decisions\n";
+
+    if (Csv_) {
+        Csv_->flush();
+    }
+}
+
+TTelemetry& GetGlobalTelemetry() {
+    static TTelemetry telemetry;
+    return telemetry;
+}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "public.h"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace Emulator {
+
+// Latencies in buckets of LATENCY_BUCKET_MICROSECONDS, everything slower goes to the last bucket.
+// Percentiles are reported as the upper bound of their bucket, the last bucket's bound is the exact maximum.
+class TLatencyHistogram {
+public:
+    static constexpr int64_t LATENCY_BUCKET_MICROSECONDS = 100;
+    static constexpr int LATENCY_BUCKETS = 1000;
+
+    void Add(int64_t microseconds);
+
+    int64_t Count() const;
+    int64_t Percentile(double fraction) const;
+    int64_t Max() const;
+
+    // "count N p50 X p99 Y max Z" in milliseconds
+    void Print(std::ostream& out) const;
+
+private:
+    std::array<int64_t, LATENCY_BUCKETS> Buckets_{};
+    int64_t Count_{0};
+    int64_t Max_{0};
+};
+
+struct TUnitDecisionTelemetry {
+    int Tick;
+    int UnitId;
+    int64_t Microseconds;
+    int ForcedEvaluated;
+    int RandomEvaluated;
+    // time resource left after the decision, negative means the budget was overrun
+    int64_t TimeResource;
+};
+
+class TTelemetry {
+public:
+    // Also streams every record as a CSV line if the AICUP_TELEMETRY_CSV environment variable names a file
+    TTelemetry();
+
+    void AddUnitDecision(const TUnitDecisionTelemetry& decision);
+    void AddTick(int tick, int64_t microseconds);
+
+    void PrintSummary(std::ostream& out) const;
+
+private:
+    TLatencyHistogram TickLatency_;
+    TLatencyHistogram UnitLatency_;
+    robin_hood::unordered_map<int, TLatencyHistogram> UnitLatencyById_;
+    int64_t ForcedEvaluated_{0};
+    int64_t RandomEvaluated_{0};
+    int64_t BudgetOverruns_{0};
+
+    std::unique_ptr<std::ofstream> Csv_;
+};
+
+TTelemetry& GetGlobalTelemetry();
+
+}
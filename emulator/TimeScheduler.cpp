@@ -0,0 +1,86 @@
+#include "TimeScheduler.h"
+
+#include <algorithm>
+
+namespace Emulator {
+
+constexpr double DANGER_WEIGHT = 2;
+constexpr double COMBAT_WEIGHT = 1;
+constexpr double IMPROVEMENT_WEIGHT = 1;
+// weight of the newest decision in the improvement rate
+constexpr double IMPROVEMENT_SMOOTHING = 0.2;
+
+void TTimeScheduler::BeginTick(const std::vector<TUnitUrgency>& urgencies, TClock::time_point tickStart) {
+    TickStart_ = tickStart;
+    Shares_.clear();
+    TotalWeight_ = 0;
+    for (const auto& urgency: urgencies) {
+        auto weight = 1 + DANGER_WEIGHT * urgency.InDanger + COMBAT_WEIGHT * urgency.InCombat
+            + IMPROVEMENT_WEIGHT * GetImprovementRate(urgency.UnitId);
+        Shares_.push_back({urgency.UnitId, weight, 0});
+        TotalWeight_ += weight;
+    }
+    for (auto& share: Shares_) {
+        share.Microseconds = static_cast<int64_t>(TICK_BUDGET_MICROSECONDS * share.Weight / TotalWeight_);
+    }
+}
+
+const TTimeScheduler::TUnitShare* TTimeScheduler::FindShare(int unitId) const {
+    for (const auto& share: Shares_) {
+        if (share.UnitId == unitId) {
+            return &share;
+        }
+    }
+    return nullptr;
+}
+
+double TTimeScheduler::GetImprovementRate(int unitId) const {
+    for (const auto& [id, rate]: ImprovementRates_) {
+        if (id == unitId) {
+            return rate;
+        }
+    }
+    // a new unit has not converged to anything yet
+    return 1;
+}
+
+TTimeScheduler::TClock::time_point TTimeScheduler::GetDeadline(int unitId, TClock::time_point decisionStart) const {
+    // a unit missing from BeginTick gets the whole tick like a lone unit would
+    double fraction = 1;
+    int64_t microseconds = TICK_BUDGET_MICROSECONDS;
+    if (const auto* share = FindShare(unitId)) {
+        fraction = share->Weight / TotalWeight_;
+        microseconds = share->Microseconds;
+    }
+    microseconds = std::max(MIN_DECISION_MICROSECONDS, microseconds + static_cast<int64_t>(Reserve_ * fraction));
+    return std::min(decisionStart + std::chrono::microseconds(microseconds), GetHardDeadline());
+}
+
+TTimeScheduler::TClock::time_point TTimeScheduler::GetHardDeadline() const {
+    return TickStart_ + std::chrono::microseconds(HARD_TICK_MICROSECONDS);
+}
+
+void TTimeScheduler::EndDecision(int unitId, int64_t microseconds, bool improved) {
+    const auto* share = FindShare(unitId);
+    Reserve_ += (share ? share->Microseconds : TICK_BUDGET_MICROSECONDS) - microseconds;
+    Reserve_ = std::clamp(Reserve_, -MAX_RESERVE_MICROSECONDS, MAX_RESERVE_MICROSECONDS);
+
+    for (auto& [id, rate]: ImprovementRates_) {
+        if (id == unitId) {
+            rate += IMPROVEMENT_SMOOTHING * (improved - rate);
+            return;
+        }
+    }
+    ImprovementRates_.emplace_back(unitId, 1 + IMPROVEMENT_SMOOTHING * (improved - 1));
+}
+
+int64_t TTimeScheduler::GetReserve() const {
+    return Reserve_;
+}
+
+TTimeScheduler& GetGlobalTimeScheduler() {
+    static TTimeScheduler scheduler;
+    return scheduler;
+}
+
+}
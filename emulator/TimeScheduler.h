@@ -0,0 +1,63 @@
+#pragma once
+
+#include "public.h"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace Emulator {
+
+struct TUnitUrgency {
+    int UnitId;
+    // TPreprocessedData::InDanger
+    bool InDanger;
+    // an enemy is within the combat radius of either unit
+    bool InCombat;
+};
+
+// Splits the time of a tick between my units by urgency. Time a decision does not use goes to a reserve
+// shared by the next decisions, overruns are paid back from it; the reserve is capped both ways.
+// Every deadline is also cut by a hard limit counted from the start of the tick.
+class TTimeScheduler {
+public:
+    using TClock = std::chrono::high_resolution_clock;
+
+    static constexpr int64_t TICK_BUDGET_MICROSECONDS = 30000;
+    static constexpr int64_t MAX_RESERVE_MICROSECONDS = 30000;
+    static constexpr int64_t HARD_TICK_MICROSECONDS = 50000;
+    static constexpr int64_t MIN_DECISION_MICROSECONDS = 1000;
+
+    void BeginTick(const std::vector<TUnitUrgency>& urgencies, TClock::time_point tickStart);
+
+    TClock::time_point GetDeadline(int unitId, TClock::time_point decisionStart) const;
+    TClock::time_point GetHardDeadline() const;
+
+    // improved tells whether the search found something better than the plan carried over from the last tick,
+    // units whose search keeps improving get more time
+    void EndDecision(int unitId, int64_t microseconds, bool improved);
+
+    int64_t GetReserve() const;
+
+private:
+    struct TUnitShare {
+        int UnitId;
+        double Weight;
+        int64_t Microseconds;
+    };
+
+    const TUnitShare* FindShare(int unitId) const;
+    double GetImprovementRate(int unitId) const;
+
+    std::vector<TUnitShare> Shares_;
+    double TotalWeight_{0};
+    TClock::time_point TickStart_{};
+    int64_t Reserve_{0};
+
+    // moving average of EndDecision's improved per unit
+    std::vector<std::pair<int, double>> ImprovementRates_;
+};
+
+TTimeScheduler& GetGlobalTimeScheduler();
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Vector2D.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Emulator {
+
+struct TBoundingBox {
+    Vector2D Min;
+    Vector2D Max;
+
+    explicit TBoundingBox(Vector2D point): Min(point), Max(point) {}
+
+    // Grows the box to cover the circle, a point for zero radius
+    void Add(Vector2D center, double radius = 0) {
+        Min = {std::min(Min.x, center.x - radius), std::min(Min.y, center.y - radius)};
+        Max = {std::max(Max.x, center.x + radius), std::max(Max.y, center.y + radius)};
+    }
+};
+
+// Square cells laid row by row from Origin, cell (x, y) is [x, x + 1) x [y, y + 1) in CellSize units.
+// Shared by the map-wide tables that need more than the unit cells of TObstacleMeta.
+struct TUniformGrid {
+    Vector2D Origin{0, 0};
+    double CellSize{0};
+    int Width{0};
+    int Height{0};
+
+    // Cells of the given size covering the box, with a spare row and column
+    static TUniformGrid Cover(const TBoundingBox& box, double cellSize) {
+        return {
+            .Origin = box.Min,
+            .CellSize = cellSize,
+            .Width = static_cast<int>(std::ceil((box.Max.x - box.Min.x) / cellSize)) + 1,
+            .Height = static_cast<int>(std::ceil((box.Max.y - box.Min.y) / cellSize)) + 1,
+        };
+    }
+
+    // Cover with the smallest cell size of minCellSize doubled some number of times that fits(grid) accepts
+    template <typename TFits>
+    static TUniformGrid Fit(const TBoundingBox& box, double minCellSize, TFits&& fits) {
+        for (double cellSize = minCellSize; ; cellSize *= 2) {
+            auto grid = Cover(box, cellSize);
+            if (fits(grid)) {
+                return grid;
+            }
+        }
+    }
+
+    [[nodiscard]] int Size() const { return Width * Height; }
+
+    // Column and row of a coordinate, may lie outside of the grid
+    [[nodiscard]] int CellX(double x) const { return static_cast<int>(std::floor((x - Origin.x) / CellSize)); }
+    [[nodiscard]] int CellY(double y) const { return static_cast<int>(std::floor((y - Origin.y) / CellSize)); }
+
+    [[nodiscard]] bool Contains(int x, int y) const { return x >= 0 && x < Width && y >= 0 && y < Height; }
+
+    // -1 outside of the grid
+    [[nodiscard]] int ToCell(Vector2D point) const {
+        auto x = CellX(point.x);
+        auto y = CellY(point.y);
+        return Contains(x, y) ? y * Width + x : -1;
+    }
+
+    // Cell of the point moved onto the grid
+    [[nodiscard]] int ToClampedCell(Vector2D point) const {
+        auto x = std::clamp(CellX(point.x), 0, Width - 1);
+        auto y = std::clamp(CellY(point.y), 0, Height - 1);
+        return y * Width + x;
+    }
+
+    // Coordinates may lie outside of the grid
+    [[nodiscard]] Vector2D CellCenter(int x, int y) const {
+        return Origin + Vector2D{(x + 0.5) * CellSize, (y + 0.5) * CellSize};
+    }
+
+    [[nodiscard]] Vector2D CellCenter(int cell) const { return CellCenter(cell % Width, cell / Width); }
+};
+
+}
@@ -12,10 +12,11 @@ std::istream& operator>>(std::istream& in, Vector2D& v) {
     return in;
 }
 
-Vector2D RandomUniformVector() {
-    double fx = (double)rand() / RAND_MAX;
-    double fy = (double)rand() / RAND_MAX;
-    return {2 * fx - 1, 2 * fy - 1};
+Vector2D RandomUniformVector(std::mt19937& random) {
+    std::uniform_real_distribution<double> distribution(-1, 1);
+    double x = distribution(random);
+    double y = distribution(random);
+    return {x, y};
 }
 
 int sign(double x) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <random>
 #include "model/Vec2.hpp"
 
 namespace Emulator {
@@ -61,7 +62,7 @@ std::ostream& operator<<(std::ostream& out, const Vector2D& v);
 
 std::istream& operator>>(std::istream& in, Vector2D& v);
 
-Vector2D RandomUniformVector();
+Vector2D RandomUniformVector(std::mt19937& random);
 
 bool SegmentIntersectsCircle(Vector2D p1, Vector2D p2, Vector2D center, double radius);
 
@@ -0,0 +1,167 @@
+#include "Visibility.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace Emulator {
+
+// keeps the offsets around a few megabytes, cells grow until they fit
+constexpr int64_t MAX_VISIBILITY_PAIRS = 1 << 19;
+constexpr double MIN_VISIBILITY_CELL_SIZE = 2;
+// rounding slack of the candidate filter
+constexpr double VISIBILITY_EPS = 1e-6;
+// candidate ids are stored as uint16_t
+constexpr size_t MAX_VISIBILITY_OBSTACLES = 1 << 16;
+
+double PointSegmentDistance(Vector2D point, Vector2D a, Vector2D b) {
+    auto segment = b - a;
+    auto length2 = abs2(segment);
+    if (length2 == 0) {
+        return abs(point - a);
+    }
+    auto t = std::clamp(((point - a) * segment) / length2, 0.0, 1.0);
+    return abs(point - (a + segment * t));
+}
+
+TVisibilityMap::TVisibilityMap(const TConstants& constants): Obstacles_(constants.obstacles) {
+    if (constants.obstacles.empty() || constants.obstacles.size() > MAX_VISIBILITY_OBSTACLES) {
+        return;
+    }
+
+    double range = constants.viewDistance;
+    for (const auto& weapon: constants.weapons) {
+        range = std::max(range, weapon.projectileSpeed * weapon.projectileLifeTime);
+    }
+
+    TBoundingBox box(constants.obstacles[0].Center);
+    for (const auto& obstacle: constants.obstacles) {
+        box.Add(obstacle.Center, obstacle.Radius);
+    }
+
+    Grid_ = TUniformGrid::Fit(box, MIN_VISIBILITY_CELL_SIZE, [&](const TUniformGrid& grid) {
+        Reach_ = static_cast<int>(std::ceil(range / grid.CellSize)) + 1;
+        RowLength_ = (2 * Reach_ + 1) * (2 * Reach_ + 1);
+        return static_cast<int64_t>(grid.Width) * grid.Height * RowLength_ <= MAX_VISIBILITY_PAIRS;
+    });
+
+    Rows_.resize(Grid_.Size());
+    RowReady_ = std::make_unique<std::atomic<bool>[]>(Grid_.Size());
+
+    Builder_ = std::jthread([this](std::stop_token stop) {
+        for (int cell = 0; cell < Grid_.Size(); ++cell) {
+            if (stop.stop_requested()) {
+                return;
+            }
+            BuildRow(cell);
+            RowReady_[cell].store(true, std::memory_order_release);
+            BuiltRows_.store(cell + 1, std::memory_order_release);
+            BuiltRows_.notify_all();
+        }
+    });
+}
+
+void TVisibilityMap::WaitUntilBuilt() const {
+    for (int built = BuiltRows_.load(std::memory_order_acquire); built < Grid_.Size(); built = BuiltRows_.load(std::memory_order_acquire)) {
+        BuiltRows_.wait(built, std::memory_order_acquire);
+    }
+}
+
+std::optional<TVisibilityMap::TPair> TVisibilityMap::Locate(Vector2D from, Vector2D to) const {
+    auto fromCell = Grid_.ToCell(from);
+    auto toCell = Grid_.ToCell(to);
+    if (fromCell == -1 || toCell == -1) {
+        return std::nullopt;
+    }
+
+    auto dx = toCell % Grid_.Width - fromCell % Grid_.Width;
+    auto dy = toCell / Grid_.Width - fromCell / Grid_.Width;
+    if (std::abs(dx) > Reach_ || std::abs(dy) > Reach_) {
+        return std::nullopt;
+    }
+    return TPair{fromCell, 2 * ((dy + Reach_) * (2 * Reach_ + 1) + (dx + Reach_))};
+}
+
+bool TVisibilityMap::Covers(Vector2D from, Vector2D to) const {
+    return Locate(from, to).has_value();
+}
+
+std::optional<bool> TVisibilityMap::IsLineClear(Vector2D from, Vector2D to, ELineKind kind) const {
+    auto pair = Locate(from, to);
+    if (!pair || !RowReady_[pair->Row].load(std::memory_order_acquire)) {
+        return std::nullopt;
+    }
+
+    const auto& row = Rows_[pair->Row];
+    auto entry = pair->Entry + kind;
+    for (auto i = row.Offsets[entry]; i < row.Offsets[entry + 1]; ++i) {
+        const auto& obstacle = Obstacles_[row.Ids[i]];
+        if (SegmentIntersectsCircle(from, to, obstacle.Center, obstacle.Radius)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Any segment between points of the two cells stays within half a cell diagonal of the segment between
+// the cell centers, so an obstacle further than that from the center segment can never cross it.
+void TVisibilityMap::BuildRow(int cell) {
+    int x = cell % Grid_.Width;
+    int y = cell / Grid_.Width;
+    auto from = Grid_.CellCenter(x, y);
+    auto halfDiagonal = Grid_.CellSize * std::sqrt(2.0) / 2;
+    auto reachDistance = (Reach_ + 1) * Grid_.CellSize * std::sqrt(2.0);
+
+    std::vector<int> nearbyObstacles;
+    for (int id = 0; id < static_cast<int>(Obstacles_.size()); ++id) {
+        const auto& obstacle = Obstacles_[id];
+        if (abs(obstacle.Center - from) < reachDistance + obstacle.Radius) {
+            nearbyObstacles.push_back(id);
+        }
+    }
+
+    auto& row = Rows_[cell];
+    row.Offsets.assign(2 * RowLength_ + 1, 0);
+    for (int dy = -Reach_; dy <= Reach_; ++dy) {
+        for (int dx = -Reach_; dx <= Reach_; ++dx) {
+            auto entry = 2 * ((dy + Reach_) * (2 * Reach_ + 1) + (dx + Reach_));
+            bool inside = Grid_.Contains(x + dx, y + dy);
+            auto to = Grid_.CellCenter(x + dx, y + dy);
+            for (auto kind: {LINE_OF_SIGHT, LINE_OF_FIRE}) {
+                for (auto id: nearbyObstacles) {
+                    const auto& obstacle = Obstacles_[id];
+                    if (inside && BlocksLine(obstacle, kind)
+                        && PointSegmentDistance(obstacle.Center, from, to) < obstacle.Radius + halfDiagonal + VISIBILITY_EPS) {
+                        row.Ids.push_back(static_cast<uint16_t>(id));
+                    }
+                }
+                row.Offsets[entry + kind + 1] = static_cast<uint32_t>(row.Ids.size());
+            }
+        }
+    }
+    row.Ids.shrink_to_fit();
+}
+
+std::unique_ptr<TVisibilityMap> GlobalVisibilityMap;
+
+void BuildGlobalVisibilityMap() {
+    assert(GetGlobalConstants());
+    // stop the old builder first, so two of them never compete for the cpu
+    GlobalVisibilityMap.reset();
+    GlobalVisibilityMap = std::make_unique<TVisibilityMap>(*GetGlobalConstants());
+}
+
+const TVisibilityMap* GetGlobalVisibilityMap() {
+    return GlobalVisibilityMap.get();
+}
+
+bool CanShootThrough(Vector2D from, Vector2D to) {
+    if (const auto* visibility = GetGlobalVisibilityMap()) {
+        if (auto clear = visibility->IsLineClear(from, to, LINE_OF_FIRE)) {
+            return *clear;
+        }
+    }
+    return !GetGlobalConstants()->obstaclesMeta.SegmentIntersectsObstacle(from, to, LINE_OF_FIRE);
+}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "public.h"
+#include "Constants.h"
+#include "UniformGrid.h"
+#include "Vector2D.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace Emulator {
+
+// Candidate obstacles of every coarse cell-to-cell line over the static obstacles for both kinds of lines, limited to
+// the longest weapon or view range: the blocking obstacles that come close enough to some segment between the two
+// cells. A line is then tested exactly against the few candidates of its cell pair, and most pairs have none.
+// Rows are built by a background thread started in the constructor. The map keeps its own copy of the obstacles,
+// so the builder never touches constants that may be replaced or destroyed meanwhile.
+class TVisibilityMap {
+public:
+    explicit TVisibilityMap(const TConstants& constants);
+
+    // Same answer as TObstacleMeta::SegmentIntersectsObstacle negated; nothing if the line is out of the table
+    // or its row is not built yet
+    std::optional<bool> IsLineClear(Vector2D from, Vector2D to, ELineKind kind) const;
+
+    // Whether IsLineClear answers about the line once its row is built
+    bool Covers(Vector2D from, Vector2D to) const;
+    // Blocks until every row is built
+    void WaitUntilBuilt() const;
+
+private:
+    // candidates of pair p and kind k are Ids[Offsets[2 * p + k], Offsets[2 * p + k + 1])
+    struct TRow {
+        std::vector<uint32_t> Offsets;
+        std::vector<uint16_t> Ids;
+    };
+
+    // row of the line's first cell and the first of its two entries in that row
+    struct TPair {
+        int Row;
+        int Entry;
+    };
+
+    void BuildRow(int cell);
+    // nothing if the line is out of the table
+    std::optional<TPair> Locate(Vector2D from, Vector2D to) const;
+
+    std::vector<TObstacle> Obstacles_;
+
+    TUniformGrid Grid_;
+    // pairs are stored for offsets up to Reach_ cells in both directions
+    int Reach_{0};
+    int RowLength_{0};
+
+    std::vector<TRow> Rows_;
+    std::unique_ptr<std::atomic<bool>[]> RowReady_;
+    // rows are built in order, notified after each one
+    std::atomic<int> BuiltRows_{0};
+
+    // declared last, so the builder is stopped before the table is destroyed
+    std::jthread Builder_;
+};
+
+void BuildGlobalVisibilityMap();
+const TVisibilityMap* GetGlobalVisibilityMap();
+
+// Answer of the table if it has one, the exact obstacle walk otherwise
+bool CanShootThrough(Vector2D from, Vector2D to);
+
+}
@@ -8,20 +8,27 @@
 #include <cassert>
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
 
 namespace Emulator {
 
+// sizes of primitives on the wire
+constexpr size_t WIRE_BOOL = 1;
+constexpr size_t WIRE_INT = 4;
+constexpr size_t WIRE_DOUBLE = 8;
+constexpr size_t WIRE_VECTOR = 2 * WIRE_DOUBLE;
+
 model::UnitOrder TOrder::ToApi() const {
     if (Aim || Shoot) {
-        return {TargetVelocity.ToApi(), TargetDirection.ToApi(), std::make_shared<model::ActionOrder::Aim>(Shoot)};
+        return {TargetVelocity.ToApi(), TargetDirection.ToApi(), model::ActionOrder::Aim(Shoot)};
     }
 
     if (Pickup) {
-        return {TargetVelocity.ToApi(), TargetDirection.ToApi(), std::make_shared<model::ActionOrder::Pickup>(LootId)};
+        return {TargetVelocity.ToApi(), TargetDirection.ToApi(), model::ActionOrder::Pickup(LootId)};
     }
 
     if (UseShieldPotion) {
-        return {TargetVelocity.ToApi(), TargetDirection.ToApi(), std::make_shared<model::ActionOrder::UseShieldPotion>()};
+        return {TargetVelocity.ToApi(), TargetDirection.ToApi(), model::ActionOrder::UseShieldPotion()};
     }
 
     return {TargetVelocity.ToApi(), TargetDirection.ToApi(), std::nullopt};
@@ -41,7 +48,7 @@ EAutomatonState updateAutomatonState(EAutomatonState state, const TWorld& world,
     auto constants = GetGlobalConstants();
     assert(constants);
 
-    const auto& unit = world.UnitById.find(UnitId)->second;
+    const auto& unit = world.Units.Get(UnitId);
 
     if (unit.RemainingSpawnTime && unit.RemainingSpawnTime > 0) {
         return RES_GATHERING;
@@ -76,8 +83,9 @@ TWorld TWorld::FormApi(const model::Game& game) {
 
     TWorld output;
 
+    output.Units.Reserve(static_cast<int>(game.units.size()));
     for (const auto& unit: game.units) {
-        output.UnitById[unit.id] = TUnit{
+        TUnit newUnit{
             .Id = unit.id,
             .PlayerId = unit.playerId,
             .Position = Vector2D::FromApi(unit.position),
@@ -91,9 +99,13 @@ TWorld TWorld::FormApi(const model::Game& game) {
             .HealthRegenerationStartTick = unit.healthRegenerationStartTick,
             .Weapon = unit.weapon,
             .NextShotTick = unit.nextShotTick,
-            .Ammo = unit.ammo,
             .ShieldPotions = unit.shieldPotions,
         };
+        if (unit.ammo.size() > newUnit.Ammo.size() || (unit.weapon && (*unit.weapon < 0 || *unit.weapon >= static_cast<int>(constants->weapons.size())))) {
+            throw std::runtime_error("Unexpected weapon type");
+        }
+        std::copy(unit.ammo.begin(), unit.ammo.end(), newUnit.Ammo.begin());
+        output.Units.InsertOrAssign(newUnit);
     }
     output.CurrentTick = game.currentTick;
     output.MyId = game.myId;
@@ -109,9 +121,9 @@ TWorld TWorld::FormApi(const model::Game& game) {
         .nextRadius = game.zone.nextRadius,
     };
 
-    output.ProjectileById.reserve(game.projectiles.size());
+    output.Projectiles.Reserve(static_cast<int>(game.projectiles.size()));
     for (auto& projectile: game.projectiles) {
-        output.ProjectileById[projectile.id] = {
+        output.Projectiles.InsertOrAssign({
             .Id = projectile.id,
             .WeaponTypeIndex = projectile.weaponTypeIndex,
             .ShooterId = projectile.shooterId,
@@ -119,62 +131,211 @@ TWorld TWorld::FormApi(const model::Game& game) {
             .Position = Vector2D::FromApi(projectile.position),
             .Velocity = Vector2D::FromApi(projectile.velocity),
             .LifeTime = projectile.lifeTime,
-        };
+        });
     }
 
-    output.LootById.reserve(game.loot.size());
+    output.Loot.Reserve(static_cast<int>(game.loot.size()));
     for (auto& loot: game.loot) {
         TLoot newLoot = {
             .Id = loot.id,
             .Position = Vector2D::FromApi(loot.position),
         };
 
-        if (auto weapon = dynamic_cast<model::Item::Weapon*>(loot.item.get())) {
+        if (auto weapon = std::get_if<model::Item::Weapon>(&loot.item)) {
             if (weapon->typeIndex != 2) {
                 continue;
             }
             newLoot.Item = Weapon;
             newLoot.WeaponType = weapon->typeIndex;
-        }
-        if (auto ammo = dynamic_cast<model::Item::Ammo*>(loot.item.get())) {
+        } else if (auto ammo = std::get_if<model::Item::Ammo>(&loot.item)) {
             if (ammo->weaponTypeIndex != 2) {
                 continue;
             }
             newLoot.Item = Ammo;
             newLoot.WeaponType = ammo->weaponTypeIndex;
             newLoot.Amount = ammo->amount;
-        }
-        if (auto potions = dynamic_cast<model::Item::ShieldPotions*>(loot.item.get())) {
+        } else if (auto potions = std::get_if<model::Item::ShieldPotions>(&loot.item)) {
             newLoot.Item = ShieldPotions;
             newLoot.Amount = potions->amount;
         }
 
-        output.LootById.insert({newLoot.Id, newLoot});
+        output.Loot.Insert(newLoot);
+    }
+
+    output.Preprocess();
+
+    return output;
+}
+
+void TWorld::ReadApi(InputStream& stream, std::vector<TSound>& sounds) {
+    if (!Constants_) {
+        Constants_ = GetGlobalConstants();
+    }
+    assert(Constants_);
+
+    // Fixed-size parts of the message are taken in place from the stream buffer and decoded from memory,
+    // only the optional fields between them cost separate reads. A reader is valid until the next read from the stream.
+    auto readChunk = [&stream](size_t size) {
+        return ByteReader(stream.readSpan(size).data());
+    };
+    auto readVector = [](ByteReader& reader) {
+        double x = reader.readDouble();
+        double y = reader.readDouble();
+        return Vector2D{x, y};
+    };
+
+    auto header = readChunk(2 * WIRE_INT);
+    MyId = header.readInt();
+    // players: id, kills, damage, place, score
+    int nPlayers = header.readInt();
+    readChunk(nPlayers * (3 * WIRE_INT + 2 * WIRE_DOUBLE));
+    header = readChunk(2 * WIRE_INT);
+    CurrentTick = header.readInt();
+
+    Units.Clear();
+    ThreatsValid_ = false;
+    int nUnits = header.readInt();
+    for (int i = 0; i < nUnits; ++i) {
+        TUnit unit{};
+        auto head = readChunk(3 * WIRE_INT + 2 * WIRE_DOUBLE + WIRE_VECTOR + WIRE_BOOL);
+        unit.Id = head.readInt();
+        unit.PlayerId = head.readInt();
+        unit.Health = head.readDouble();
+        unit.Shield = head.readDouble();
+        unit.ExtraLives = head.readInt();
+        unit.Position = readVector(head);
+        if (head.readBool()) {
+            unit.RemainingSpawnTime = stream.readDouble();
+        }
+        auto motion = readChunk(2 * WIRE_VECTOR + WIRE_DOUBLE + WIRE_BOOL);
+        unit.Velocity = readVector(motion);
+        unit.Direction = readVector(motion);
+        unit.Aim = motion.readDouble();
+        // current action: finish tick and action type
+        if (motion.readBool()) {
+            readChunk(2 * WIRE_INT);
+        }
+        auto regeneration = readChunk(WIRE_INT + WIRE_BOOL);
+        unit.HealthRegenerationStartTick = regeneration.readInt();
+        if (regeneration.readBool()) {
+            unit.Weapon = stream.readInt();
+            if (*unit.Weapon < 0 || *unit.Weapon >= static_cast<int>(Constants_->weapons.size())) {
+                throw std::runtime_error("Unexpected weapon type");
+            }
+        }
+        auto weapons = readChunk(2 * WIRE_INT);
+        unit.NextShotTick = weapons.readInt();
+        int nAmmo = weapons.readInt();
+        // the ammo array is fixed, a longer list would be written past it
+        if (nAmmo < 0 || nAmmo > static_cast<int>(unit.Ammo.size())) {
+            throw std::runtime_error("Unexpected ammo count");
+        }
+        stream.readInts(unit.Ammo.data(), nAmmo);
+        unit.ShieldPotions = stream.readInt();
+        Units.InsertOrAssign(unit);
+    }
+
+    Loot.Clear();
+    int nLoot = stream.readInt();
+    for (int i = 0; i < nLoot; ++i) {
+        auto head = readChunk(WIRE_INT + WIRE_VECTOR + WIRE_INT);
+        TLoot loot = {
+            .Id = head.readInt(),
+            .Position = readVector(head),
+        };
+
+        bool keep = true;
+        switch (head.readInt()) {
+            case Weapon:
+                loot.Item = Weapon;
+                loot.WeaponType = stream.readInt();
+                keep = loot.WeaponType == 2;
+                break;
+            case ShieldPotions:
+                loot.Item = ShieldPotions;
+                loot.Amount = stream.readInt();
+                break;
+            case Ammo: {
+                auto ammo = readChunk(2 * WIRE_INT);
+                loot.Item = Ammo;
+                loot.WeaponType = ammo.readInt();
+                loot.Amount = ammo.readInt();
+                keep = loot.WeaponType == 2;
+                break;
+            }
+            default:
+                throw std::runtime_error("Unexpected tag value");
+        }
+
+        if (keep) {
+            Loot.Insert(loot);
+        }
     }
 
-    for (const auto& [_, unit]: output.UnitById) {
-        if (unit.PlayerId != output.MyId) {
+    // projectiles have no optional fields, so all of them come in one read
+    Projectiles.Clear();
+    int nProjectiles = stream.readInt();
+    auto projectiles = readChunk(nProjectiles * (4 * WIRE_INT + 2 * WIRE_VECTOR + WIRE_DOUBLE));
+    for (int i = 0; i < nProjectiles; ++i) {
+        TProjectile projectile{};
+        projectile.Id = projectiles.readInt();
+        projectile.WeaponTypeIndex = projectiles.readInt();
+        projectile.ShooterId = projectiles.readInt();
+        projectile.ShooterPlayerId = projectiles.readInt();
+        projectile.Position = readVector(projectiles);
+        projectile.Velocity = readVector(projectiles);
+        projectile.LifeTime = projectiles.readDouble();
+        Projectiles.InsertOrAssign(projectile);
+    }
+
+    auto zone = readChunk(2 * WIRE_VECTOR + 2 * WIRE_DOUBLE + WIRE_INT);
+    Zone.currentCenter = readVector(zone);
+    Zone.currentRadius = zone.readDouble();
+    Zone.nextCenter = readVector(zone);
+    Zone.nextRadius = zone.readDouble();
+
+    sounds.clear();
+    int nSounds = zone.readInt();
+    auto soundBytes = readChunk(nSounds * (2 * WIRE_INT + WIRE_VECTOR));
+    for (int i = 0; i < nSounds; ++i) {
+        TSound sound{};
+        sound.TypeIndex = soundBytes.readInt();
+        sound.UnitId = soundBytes.readInt();
+        sound.Position = readVector(soundBytes);
+        sounds.push_back(sound);
+    }
+
+    for (auto& index: LootIndexByItem) {
+        index.Clear();
+    }
+    StateByUnitId.clear();
+    LootIdByUnitId.reset();
+    Preprocess();
+}
+
+void TWorld::Preprocess() {
+    PreprocessedDataById.clear();
+
+    for (const auto& unit: Units) {
+        if (unit.PlayerId != MyId) {
             continue;
         }
 
-        auto& preprocessedData = output.PreprocessedDataById[unit.Id];
+        auto& preprocessedData = PreprocessedDataById[unit.Id];
 
-        for (const auto& [projectileId, projectile]: output.ProjectileById) {
-            if (SegmentIntersectsCircle(projectile.Position, projectile.Position + projectile.Velocity * projectile.LifeTime, unit.Position, constants->unitRadius)) {
+        for (const auto& projectile: Projectiles) {
+            if (SegmentIntersectsCircle(projectile.Position, projectile.Position + projectile.Velocity * projectile.LifeTime, unit.Position, Constants_->unitRadius)) {
                 preprocessedData.InDanger = true;
             }
         }
 
-        for (const auto& [otherUnitId, otherUnit]: output.UnitById) {
+        for (const auto& otherUnit: Units) {
             if (otherUnit.PlayerId != unit.PlayerId) {
                 continue;
             }
-            preprocessedData.Friends.push_back(otherUnitId);
+            preprocessedData.Friends.push_back(otherUnit.Id);
         }
     }
-
-
-    return output;
 }
 
 void TWorld::Emulate(const std::vector<TOrder> &orders) {
@@ -193,9 +354,7 @@ void TWorld::EmulateOrder(const TOrder &order) {
 
     auto unitId = order.UnitId;
 
-    assert(UnitById.contains(unitId));
-
-    auto &unit = UnitById[unitId];
+    auto &unit = Units.Get(unitId);
 
     auto targetVelocity = ClipVelocity(order.TargetVelocity, unit);
     auto velocity = ApplyAcceleration(unit.Velocity, targetVelocity);
@@ -231,10 +390,7 @@ Vector2D TWorld::ClipVelocity(Vector2D velocity, const TUnit &unit) {
 
     auto limit = sqrt(projection * projection + Constants_->maxUnitBackwardSpeed * Constants_->maxUnitForwardSpeed) + projection;
 
-    if (unit.Weapon) {
-        // TODO: better aim simulation
-        limit *= (1 - (1 - Constants_->weapons[*unit.Weapon].aimMovementSpeedModifier) * unit.Aim);
-    }
+    limit *= GetAimSpeedFactor(unit);
 
     if (abs(velocity) < limit) {
         return velocity;
@@ -243,6 +399,14 @@ Vector2D TWorld::ClipVelocity(Vector2D velocity, const TUnit &unit) {
     return norm(velocity) * limit;
 }
 
+double TWorld::GetAimSpeedFactor(const TUnit& unit) const {
+    if (!unit.Weapon) {
+        return 1;
+    }
+    // TODO: better aim simulation
+    return 1 - (1 - Constants_->weapons[*unit.Weapon].aimMovementSpeedModifier) * unit.Aim;
+}
+
 Vector2D TWorld::ApplyAcceleration(Vector2D velocity, Vector2D targetVelocity) {
     auto desiredDelta = targetVelocity - velocity;
 
@@ -261,10 +425,7 @@ void TWorld::MoveCollidingUnit(TUnit& unit, Vector2D velocity) {
     assert(Constants_);
 
     unit.Velocity = velocity;
-
-    if (!Constants_->obstaclesMeta.IsInitialized()) {
-        Constants_->obstaclesMeta = TObstacleMeta(Constants_->obstacles);
-    }
+    assert(Constants_->obstaclesMeta.IsInitialized());
 
     for (const auto& obstacleId: Constants_->obstaclesMeta.GetIntersectingIds(unit.Position)) {
         if (unit.RemainingSpawnTime > 0) {
@@ -290,85 +451,99 @@ void TWorld::MoveCollidingUnit(TUnit& unit, Vector2D velocity) {
     unit.Position = unit.Position + unit.Velocity / Constants_->ticksPerSecond;
 }
 
+bool TWorld::MoveProjectile(TProjectile& projectile) {
+    projectile.LifeTime -= 1 / Constants_->ticksPerSecond;
+    if (projectile.LifeTime < 0) {
+        return false;
+    }
+    auto newPosition = projectile.Position + projectile.Velocity / Constants_->ticksPerSecond;
+
+    auto obstacle = Constants_->obstaclesMeta.GetObstacle(projectile.Position);
+    if (obstacle && !Constants_->obstacles[*obstacle].CanShootThrough) {
+        return false;
+    }
+
+    int shooterPlayerId = -1;
+    if (const auto* shooter = Units.Find(projectile.ShooterId)) {
+        shooterPlayerId = shooter->PlayerId;
+    }
+
+    for (auto& unit: Units) {
+        // TODO: microticks or other stuff
+        if (SegmentIntersectsCircle(projectile.Position, projectile.Position + (projectile.Velocity - unit.Velocity) / Constants_->ticksPerSecond, unit.Position, Constants_->unitRadius)) {
+            if (unit.PlayerId != shooterPlayerId) {
+                unit.Health -= Constants_->weapons[projectile.WeaponTypeIndex].projectileDamage;
+            }
+            return false;
+        }
+    }
+
+    projectile.Position = newPosition;
+    return true;
+}
+
 void TWorld::PrepareEmulation() {
     if (!Constants_) {
         Constants_ = GetGlobalConstants();
     }
     assert(Constants_);
 
-    std::vector<int> idsToErase;
+    Projectiles.EraseIf([this](TProjectile& projectile) {
+        return !MoveProjectile(projectile);
+    });
 
-    for (auto& [_, projectile]: ProjectileById) {
-        projectile.LifeTime -= 1 / Constants_->ticksPerSecond;
-        if (projectile.LifeTime < 0) {
-            idsToErase.push_back(projectile.Id);
-            continue;
-        }
-        auto newPosition = projectile.Position + projectile.Velocity / Constants_->ticksPerSecond;
+    MoveEnemies();
 
-        auto obstacle = Constants_->obstaclesMeta.GetObstacle(projectile.Position);
-        if (obstacle && !Constants_->obstacles[*obstacle].CanShootThrough) {
-            idsToErase.push_back(projectile.Id);
+    for (auto& unit: Units) {
+        if (unit.PlayerId != MyId) {
             continue;
         }
+        ApplyEnvironmentDamage(unit);
+    }
+}
 
-        int shooterPlayerId = -1;
-        if (UnitById.contains(projectile.ShooterId)) {
-            shooterPlayerId = UnitById.find(projectile.ShooterId)->second.PlayerId;
-        }
-
-        for (auto& [unitId, unit]: UnitById) {
-            // TODO: microticks or other stuff
-            if (SegmentIntersectsCircle(projectile.Position, projectile.Position + (projectile.Velocity - unit.Velocity) / Constants_->ticksPerSecond, unit.Position, Constants_->unitRadius)) {
-                if (unit.PlayerId != shooterPlayerId) {
-                    unit.Health -= Constants_->weapons[projectile.WeaponTypeIndex].projectileDamage;
-                }
-                idsToErase.push_back(projectile.Id);
-                break;
-            }
+void TWorld::EmulateTeammates(int plannedUnitId) {
+    for (const auto& [unitId, strategy]: TeammateStrategies) {
+        if (unitId == plannedUnitId || !Units.Contains(unitId) || !StateByUnitId.contains(unitId) || !PreprocessedDataById.contains(unitId)) {
+            continue;
         }
-
-        projectile.Position = newPosition;
+        auto& state = StateByUnitId[unitId];
+        state.Sync(*this);
+        auto order = strategy.GetOrder(*this, unitId);
+        EmulateOrder(order);
+        state.Update(*this, order);
     }
+}
 
-    for (auto& [unitId, unit]: UnitById) {
+void TWorld::MoveEnemies() {
+    ThreatsValid_ = false;
+    for (auto& unit: Units) {
         if (unit.PlayerId == MyId) {
             continue;
         }
 
         unit.Position = unit.Position + unit.Velocity / Constants_->ticksPerSecond;
     }
+}
 
-    for (auto id: idsToErase) {
-        ProjectileById.erase(id);
+void TWorld::ApplyEnvironmentDamage(TUnit& unit) {
+    if (abs(unit.Position - Zone.currentCenter) > Zone.currentRadius - Constants_->unitRadius * 3) {
+        unit.Health -= Constants_->zoneDamagePerSecond / Constants_->ticksPerSecond;
     }
 
-    for (auto& [unitId, unit]: UnitById) {
-        if (unit.PlayerId != MyId) {
-            continue;
-        }
-        if (abs(unit.Position - Zone.currentCenter) > Zone.currentRadius - Constants_->unitRadius * 3) {
-            unit.Health -= Constants_->zoneDamagePerSecond / Constants_->ticksPerSecond;
-        }
+    if (!unit.RemainingSpawnTime) {
+        return;
+    }
+    unit.RemainingSpawnTime = *unit.RemainingSpawnTime - 1 / Constants_->ticksPerSecond;
+    if (unit.RemainingSpawnTime <= 0) {
+        unit.RemainingSpawnTime = std::nullopt;
     }
-    for (auto& [unitId, unit]: UnitById) {
-        if (unit.PlayerId != MyId) {
-            continue;
-        }
-        if (!unit.RemainingSpawnTime) {
-            continue;
-        }
-        unit.RemainingSpawnTime = *unit.RemainingSpawnTime - 1 / Constants_->ticksPerSecond;
-        if (unit.RemainingSpawnTime <= 0) {
-            unit.RemainingSpawnTime = std::nullopt;
-        }
 
-        for (auto obstacleId: Constants_->obstaclesMeta.GetIntersectingIds(unit.Position)) {
-            const auto& obstacle = Constants_->obstacles[obstacleId];
-            if (abs(obstacle.Center - unit.Position) <= (obstacle.Radius + Constants_->unitRadius - 0.08)) {
-                // it's hard to make a proper simulation, so let's just assume that this damage is bad
-                unit.Health -= 10000;
-            }
+    for (auto obstacleId: Constants_->obstaclesMeta.GetIntersectingIds(unit.Position)) {
+        const auto& obstacle = Constants_->obstacles[obstacleId];
+        if (abs(obstacle.Center - unit.Position) <= (obstacle.Radius + Constants_->unitRadius - 0.08)) {
+            // it's hard to make a proper simulation, so let's just assume that this damage is bad
+            unit.Health -= 10000;
         }
     }
 }
@@ -378,6 +553,68 @@ void TWorld::Tick() {
 
     ++CurrentTick;
     Zone.currentRadius -= Constants_->zoneSpeed / Constants_->ticksPerSecond;
+    ThreatsValid_ = false;
+}
+
+void TWorld::SaveCheckpoint(TWorldCheckpoint& checkpoint) const {
+    checkpoint.CurrentTick = CurrentTick;
+    checkpoint.Zone = Zone;
+    checkpoint.Units = Units;
+    checkpoint.Projectiles = Projectiles;
+    checkpoint.StateByUnitId = StateByUnitId;
+}
+
+void TWorld::RestoreCheckpoint(const TWorldCheckpoint& checkpoint) {
+    CurrentTick = checkpoint.CurrentTick;
+    Zone = checkpoint.Zone;
+    Units = checkpoint.Units;
+    Projectiles = checkpoint.Projectiles;
+    StateByUnitId = checkpoint.StateByUnitId;
+    ThreatsValid_ = false;
+}
+
+void TWorld::UpdateThreats() {
+    CollectThreats(Threats_);
+    ThreatsValid_ = true;
+}
+
+const std::vector<TThreat>* TWorld::GetThreats() const {
+    return ThreatsValid_ ? &Threats_ : nullptr;
+}
+
+void TWorld::CollectThreats(std::vector<TThreat>& threats) const {
+    threats.clear();
+    for (const auto& unit: Units) {
+        if (unit.PlayerId == MyId) {
+            continue;
+        }
+        threats.push_back({
+            .UnitId = unit.Id,
+            .Position = unit.Position,
+            .CombatRadius = unit.GetCombatRadius(),
+            .Weapon = unit.Weapon,
+            .Health = unit.Health,
+            .Shield = unit.Shield,
+        });
+    }
+}
+
+void TRollout::Reset(const TWorld& root) {
+    Root_ = root;
+    World_ = root;
+    Root_.SaveCheckpoint(Checkpoint_);
+}
+
+void TRollout::Rewind() {
+    World_.RestoreCheckpoint(Checkpoint_);
+}
+
+const TWorld& TRollout::Root() const {
+    return Root_;
+}
+
+TWorld& TRollout::World() {
+    return World_;
 }
 
 const std::string LOAD_DUMP_VERSION = "6.0";
@@ -394,8 +631,8 @@ void TWorld::Dump(const char *filename) {
 
     fout << MyId << std::endl;
 
-    fout << UnitById.size() << std::endl;
-    for (const auto& [_, unit]: UnitById) {
+    fout << Units.Size() << std::endl;
+    for (const auto& unit: Units) {
         fout << unit.Id << std::endl;
         fout << unit.PlayerId << std::endl;
         fout << unit.Position << std::endl;
@@ -407,7 +644,8 @@ void TWorld::Dump(const char *filename) {
 void TWorld::Load(const char *filename) {
     std::ifstream fin(filename);
     fin.precision(20);
-    UnitById = {};
+    Units.Clear();
+    ThreatsValid_ = false;
 
     std::string version;
     fin >> version;
@@ -436,29 +674,31 @@ void TWorld::Load(const char *filename) {
         fin >> unit.Position;
         fin >> unit.Direction;
         fin >> unit.Velocity;
-        UnitById[unit.PlayerId] = unit;
+        Units.InsertOrAssign(unit);
     }
 }
 void TWorld::UpdateLootIndex() {
-    LootByItemIndex.clear();
-    for (auto& [_, loot]: LootById) {
-        LootByItemIndex[loot.Item].push_back(loot);
+    static thread_local std::array<std::vector<TIndexedLoot>, LOOT_ITEM_TYPES> lootByItem;
+    for (auto& items: lootByItem) {
+        items.clear();
+    }
+    for (const auto& loot: Loot) {
+        lootByItem[loot.Item].push_back({loot.Id, loot.Position});
+    }
+    for (int item = 0; item < LOOT_ITEM_TYPES; ++item) {
+        LootIndexByItem[item].Build(lootByItem[item]);
     }
-    // initialisation
-    LootByItemIndex[Weapon];
-    LootByItemIndex[ShieldPotions];
-    LootByItemIndex[Ammo];
 }
 
 void TWorld::UpdateUnitsTargetLoot() {
     LootIdByUnitId = std::nullopt;
 
     robin_hood::unordered_map<int, std::optional<int>> lootIdByUnitId;
-    for (auto& [unitId, unit]: UnitById) {
+    for (auto& unit: Units) {
         if (unit.PlayerId != MyId) {
             continue;
         }
-        lootIdByUnitId[unitId] = GetTargetLoot(*this, unitId);
+        lootIdByUnitId[unit.Id] = GetTargetLoot(*this, unit.Id);
     }
 
     LootIdByUnitId = std::move(lootIdByUnitId);
@@ -471,8 +711,7 @@ double TUnit::GetCombatRadius() const {
     if (!Weapon) {
         return 0;
     }
-    const auto& weaponProperties = constants->weapons[*Weapon];
-    return weaponProperties.projectileSpeed * weaponProperties.projectileLifeTime;
+    return constants->weaponCombat[*Weapon].CombatRadius;
 }
 
 }
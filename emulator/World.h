@@ -1,12 +1,20 @@
 #pragma once
 
 #include "public.h"
-#include "Vector2D.h"
 #include "Constants.h"
+#include "DenseMap.h"
+#include "LootIndex.h"
+#include "Sound.h"
+#include "Strategy.h"
+#include "Vector2D.h"
+
+#include "Stream.hpp"
 
 #include "model/Game.hpp"
 #include "model/UnitOrder.hpp"
 
+#include <array>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
@@ -26,13 +34,14 @@ struct TUnit {
     int HealthRegenerationStartTick;
     std::optional<int> Weapon;
     int NextShotTick;
-    std::vector<int> Ammo;
+    std::array<int, MAX_WEAPON_TYPES> Ammo{};
     int ShieldPotions;
 
     bool Imaginable{false};
 
     double GetCombatRadius() const;
 };
+static_assert(std::is_trivially_copyable_v<TUnit>);
 
 struct TOrder {
     int UnitId;
@@ -64,12 +73,14 @@ struct TProjectile {
     Vector2D Velocity;
     double LifeTime;
 };
+static_assert(std::is_trivially_copyable_v<TProjectile>);
 
 enum ELootItem {
     Weapon = 0,
     ShieldPotions = 1,
     Ammo = 2,
 };
+constexpr int LOOT_ITEM_TYPES = 3;
 
 struct TLoot {
     int Id;
@@ -78,6 +89,7 @@ struct TLoot {
     int WeaponType;
     int Amount;
 };
+static_assert(std::is_trivially_copyable_v<TLoot>);
 
 struct TState {
     void Update(const TWorld& world, const TOrder& order);
@@ -92,42 +104,115 @@ struct TState {
     EAutomatonState AutomatonState{RES_GATHERING};
 };
 
+// An enemy as GetCombatSafety sees it
+struct TThreat {
+    int UnitId;
+    Vector2D Position;
+    double CombatRadius;
+    std::optional<int> Weapon;
+    double Health;
+    double Shield;
+};
+
 struct TPreprocessedData {
     bool InDanger{false};
     std::vector<int> Friends;
 };
 
+// Everything a strategy emulation may change in a world
+struct TWorldCheckpoint {
+    int CurrentTick;
+    TZone Zone;
+    TDenseMap<TUnit> Units;
+    TDenseMap<TProjectile> Projectiles;
+    robin_hood::unordered_map<int, TState> StateByUnitId;
+};
+
 class TWorld {
 public:
     void Emulate(const std::vector<TOrder>& orders);
     static TWorld FormApi(const model::Game& game);
+    // Same world as FormApi, decoded straight from the model::Game wire format without building model objects.
+    // Reuses the storage of this world; sounds heard this tick go to sounds.
+    void ReadApi(InputStream& stream, std::vector<TSound>& sounds);
 
     void Dump(const char* filename);
     void Load(const char* filename);
 
     int MyId;
     int CurrentTick;
-    robin_hood::unordered_map<int, TUnit> UnitById;
+    TDenseMap<TUnit> Units;
     TZone Zone;
-    robin_hood::unordered_map<int, TProjectile> ProjectileById;
-    robin_hood::unordered_map<int, TLoot> LootById;
-    robin_hood::unordered_map<int, std::vector<TLoot>> LootByItemIndex;
+    TDenseMap<TProjectile> Projectiles;
+    TDenseMap<TLoot> Loot;
+    // indexed by ELootItem, rebuilt by UpdateLootIndex
+    std::array<TLootIndex, LOOT_ITEM_TYPES> LootIndexByItem;
     robin_hood::unordered_map<int, TState> StateByUnitId;
     std::optional<robin_hood::unordered_map<int, std::optional<int>>> LootIdByUnitId;
     robin_hood::unordered_map<int, TPreprocessedData> PreprocessedDataById;
 
+    // Strategies my other units are expected to follow, emulated together with the planned unit.
+    // Not part of checkpoints, it stays the same during a rollout
+    std::vector<std::pair<int, TStrategy>> TeammateStrategies;
+
     void PrepareEmulation();
+    // Moves every teammate but the planned unit by its strategy, call it after PrepareEmulation.
+    // Teammate orders never depend on the planned unit's position, so batch lanes can share them
+    void EmulateTeammates(int plannedUnitId);
     void EmulateOrder(const TOrder& order);
     void Tick();
     void UpdateLootIndex();
     void UpdateUnitsTargetLoot();
+    // Fills PreprocessedDataById for my units
+    void Preprocess();
+
+    // Enemies in Units order, built once so GetCombatSafety does not re-derive them on every query.
+    // Emulation, checkpoint restores and decoding invalidate the table, so it only lives on worlds that
+    // stay still, like rollout roots. Call UpdateThreats again after changing Units by hand.
+    void UpdateThreats();
+    // nullptr if the table is not built or no longer valid
+    const std::vector<TThreat>* GetThreats() const;
+    void CollectThreats(std::vector<TThreat>& threats) const;
+
+    // Both reuse the storage of the destination, so a warmed up checkpoint costs no allocations
+    void SaveCheckpoint(TWorldCheckpoint& checkpoint) const;
+    void RestoreCheckpoint(const TWorldCheckpoint& checkpoint);
 private:
     Vector2D ClipVelocity(Vector2D velocity, const TUnit& unit);
+    // Factor the speed limit of the unit is scaled by while it aims
+    double GetAimSpeedFactor(const TUnit& unit) const;
     Vector2D ApplyAcceleration(Vector2D velocity, Vector2D targetVelocity);
     void MoveCollidingUnit(TUnit& unit, Vector2D velocity);
+    // Returns false if the projectile is gone after this tick
+    bool MoveProjectile(TProjectile& projectile);
     void RotateUnit(TUnit& unit, Vector2D targetDirection);
+    void MoveEnemies();
+    // Zone damage and spawn countdown of one of my units
+    void ApplyEnvironmentDamage(TUnit& unit);
+
+    // the batch emulator runs the same per-unit steps on its own lane copies of a unit
+    friend class TBatchEmulator;
 
     TConstantsPtr Constants_ = nullptr;
+
+    std::vector<TThreat> Threats_;
+    bool ThreatsValid_{false};
+};
+
+// Scratch world for emulating many strategies from one root state.
+// A rollout mutates World() in place and Rewind() brings it back to the root.
+class TRollout {
+public:
+    void Reset(const TWorld& root);
+    void Rewind();
+
+    const TWorld& Root() const;
+    TWorld& World();
+
+private:
+    TWorld Root_;
+    TWorld World_;
+    TWorldCheckpoint Checkpoint_;
 };
 
 }
@@ -10,6 +10,10 @@ struct TOrder;
 
 class TWorld;
 
+class TRollout;
+
+class TBatchEmulator;
+
 struct Vector2D;
 
 struct TStrategyAction;
@@ -28,6 +32,8 @@ struct TLoot;
 
 struct TState;
 
+struct TSound;
+
 enum EAutomatonState {
     RES_GATHERING = 0,
     FIGHT = 1,
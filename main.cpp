@@ -1,8 +1,12 @@
 #include "DebugInterface.hpp"
 #include "MyStrategy.hpp"
+#include "ReplayStream.hpp"
 #include "TcpStream.hpp"
 #include "codegame/ServerMessage.hpp"
 #include "codegame/ClientMessage.hpp"
+#include "emulator/Sound.h"
+#include "emulator/World.h"
+#include <cstdlib>
 #include <memory>
 #include <string>
 
@@ -16,24 +20,47 @@ public:
         tcpStream.write(int(1));
         tcpStream.flush();
     }
+    // Save every server message into a replay file for testbin/replay_runner
+    void record(const std::string& path)
+    {
+        recording = std::make_unique<FileOutputStream>(path);
+        writeReplayHeader(*recording);
+        recordingTee = std::make_unique<TeeInputStream>(tcpStream, *recording);
+    }
     void run()
     {
         DebugInterface debugInterface(&tcpStream);
+        // Debug primitives are sent by a background thread one tick late, the order is never held up by them
+        debugInterface.setAsync(std::getenv("AICUP_ASYNC_DEBUG") != nullptr);
         std::shared_ptr<MyStrategy> myStrategy = std::shared_ptr<MyStrategy>();
+        InputStream& input = recordingTee ? static_cast<InputStream&>(*recordingTee) : tcpStream;
         while (true) {
-            auto message = codegame::ServerMessage::readFrom(tcpStream);
-            if (auto updateConstantsMessage = std::dynamic_pointer_cast<codegame::ServerMessage::UpdateConstants>(message)) {
-                myStrategy.reset(new MyStrategy(updateConstantsMessage->constants));
-            } else if (auto getOrderMessage = std::dynamic_pointer_cast<codegame::ServerMessage::GetOrder>(message)) {
-                codegame::ClientMessage::OrderMessage(myStrategy->getOrder(getOrderMessage->playerView, getOrderMessage->debugAvailable ? &debugInterface : nullptr)).writeTo(tcpStream);
+            // GetOrder is decoded straight into the emulator world, other messages go through the generated model
+            int tag = input.readInt();
+            if (tag == codegame::ServerMessage::GetOrder::TAG) {
+                world.ReadApi(input, sounds);
+                bool debugAvailable = input.readBool();
+                flushRecording();
+                auto order = myStrategy->getOrder(world, sounds, debugAvailable ? &debugInterface : nullptr);
+                debugInterface.beforeReply();
+                codegame::ClientMessage::OrderMessage(order).writeTo(tcpStream);
                 tcpStream.flush();
-            } else if (auto finishMessage = std::dynamic_pointer_cast<codegame::ServerMessage::Finish>(message)) {
+                debugInterface.afterReply();
+            } else if (tag == codegame::ServerMessage::UpdateConstants::TAG) {
+                auto updateConstantsMessage = codegame::ServerMessage::UpdateConstants::readFrom(input);
+                flushRecording();
+                myStrategy.reset(new MyStrategy(updateConstantsMessage.constants));
+            } else if (tag == codegame::ServerMessage::Finish::TAG) {
+                flushRecording();
                 myStrategy->finish();
                 break;
-            } else if (auto debugUpdateMessage = std::dynamic_pointer_cast<codegame::ServerMessage::DebugUpdate>(message)) {
+            } else if (tag == codegame::ServerMessage::DebugUpdate::TAG) {
+                flushRecording();
                 myStrategy->debugUpdate(debugInterface);
+                debugInterface.beforeReply();
                 codegame::ClientMessage::DebugUpdateDone().writeTo(tcpStream);
                 tcpStream.flush();
+                debugInterface.afterReply();
             } else {
                 throw std::runtime_error("Unexpected server message");
             }
@@ -41,7 +68,20 @@ public:
     }
 
 private:
+    // Called once a whole message is read, so a replay never ends in the middle of a message
+    void flushRecording()
+    {
+        if (recording) {
+            recording->flush();
+        }
+    }
+
     TcpStream tcpStream;
+    std::unique_ptr<FileOutputStream> recording;
+    std::unique_ptr<TeeInputStream> recordingTee;
+    // reused every tick, so decoding does not reallocate the world
+    Emulator::TWorld world;
+    std::vector<Emulator::TSound> sounds;
 };
 
 int main(int argc, char* argv[])
@@ -50,6 +90,10 @@ int main(int argc, char* argv[])
     std::string host = argc < 2 ? "127.0.0.1" : argv[1];
     int port = argc < 3 ? 31001 : atoi(argv[2]);
     std::string token = argc < 4 ? "0000000000000000" : argv[3];
-    Runner(host, port, token).run();
+    Runner runner(host, port, token);
+    if (argc >= 5) {
+        runner.record(argv[4]);
+    }
+    runner.run();
     return 0;
 }
\ No newline at end of file
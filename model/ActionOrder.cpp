@@ -188,4 +188,34 @@ std::shared_ptr<ActionOrder> ActionOrder::readFrom(InputStream& stream) {
     }
 }
 
+// Read ActionOrderValue from input stream
+ActionOrderValue readActionOrderValue(InputStream& stream) {
+    switch (stream.readInt()) {
+    case 0:
+        return ActionOrder::Pickup::readFrom(stream);
+    case 1:
+        return ActionOrder::UseShieldPotion::readFrom(stream);
+    case 2:
+        return ActionOrder::DropShieldPotions::readFrom(stream);
+    case 3:
+        return ActionOrder::DropWeapon::readFrom(stream);
+    case 4:
+        return ActionOrder::DropAmmo::readFrom(stream);
+    case 5:
+        return ActionOrder::Aim::readFrom(stream);
+    default:
+        throw std::runtime_error("Unexpected tag value");
+    }
+}
+
+// Write ActionOrderValue to output stream
+void writeActionOrderValue(OutputStream& stream, const ActionOrderValue& value) {
+    std::visit([&stream](const auto& alternative) { alternative.writeTo(stream); }, value);
+}
+
+// Get string representation of ActionOrderValue
+std::string actionOrderValueToString(const ActionOrderValue& value) {
+    return std::visit([](const auto& alternative) { return alternative.toString(); }, value);
+}
+
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <variant>
 
 namespace model {
 
@@ -164,6 +165,18 @@ public:
     bool operator ==(const Aim& other) const;
 };
 
+// Order to perform an action stored by value, alternatives follow the tag order
+using ActionOrderValue = std::variant<ActionOrder::Pickup, ActionOrder::UseShieldPotion, ActionOrder::DropShieldPotions, ActionOrder::DropWeapon, ActionOrder::DropAmmo, ActionOrder::Aim>;
+
+// Read ActionOrderValue from input stream
+ActionOrderValue readActionOrderValue(InputStream& stream);
+
+// Write ActionOrderValue to output stream
+void writeActionOrderValue(OutputStream& stream, const ActionOrderValue& value);
+
+// Get string representation of ActionOrderValue
+std::string actionOrderValueToString(const ActionOrderValue& value);
+
 }
 
 #endif
\ No newline at end of file
@@ -106,4 +106,28 @@ std::shared_ptr<Item> Item::readFrom(InputStream& stream) {
     }
 }
 
+// Read ItemValue from input stream
+ItemValue readItemValue(InputStream& stream) {
+    switch (stream.readInt()) {
+    case 0:
+        return Item::Weapon::readFrom(stream);
+    case 1:
+        return Item::ShieldPotions::readFrom(stream);
+    case 2:
+        return Item::Ammo::readFrom(stream);
+    default:
+        throw std::runtime_error("Unexpected tag value");
+    }
+}
+
+// Write ItemValue to output stream
+void writeItemValue(OutputStream& stream, const ItemValue& value) {
+    std::visit([&stream](const auto& alternative) { alternative.writeTo(stream); }, value);
+}
+
+// Get string representation of ItemValue
+std::string itemValueToString(const ItemValue& value) {
+    return std::visit([](const auto& alternative) { return alternative.toString(); }, value);
+}
+
 }
\ No newline at end of file
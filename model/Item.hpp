@@ -5,6 +5,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <variant>
 
 namespace model {
 
@@ -96,6 +97,18 @@ public:
     bool operator ==(const Ammo& other) const;
 };
 
+// Lootable item stored by value, alternatives follow the tag order
+using ItemValue = std::variant<Item::Weapon, Item::ShieldPotions, Item::Ammo>;
+
+// Read ItemValue from input stream
+ItemValue readItemValue(InputStream& stream);
+
+// Write ItemValue to output stream
+void writeItemValue(OutputStream& stream, const ItemValue& value);
+
+// Get string representation of ItemValue
+std::string itemValueToString(const ItemValue& value);
+
 }
 
 #endif
\ No newline at end of file
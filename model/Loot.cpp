@@ -2,13 +2,13 @@
 
 namespace model {
 
-Loot::Loot(int id, model::Vec2 position, std::shared_ptr<model::Item> item) : id(id), position(position), item(item) { }
+Loot::Loot(int id, model::Vec2 position, model::ItemValue item) : id(id), position(position), item(item) { }
 
 // Read Loot from input stream
 Loot Loot::readFrom(InputStream& stream) {
     int id = stream.readInt();
     model::Vec2 position = model::Vec2::readFrom(stream);
-    std::shared_ptr<model::Item> item = model::Item::readFrom(stream);
+    model::ItemValue item = model::readItemValue(stream);
     return Loot(id, position, item);
 }
 
@@ -16,7 +16,7 @@ Loot Loot::readFrom(InputStream& stream) {
 void Loot::writeTo(OutputStream& stream) const {
     stream.write(id);
     position.writeTo(stream);
-    item->writeTo(stream);
+    model::writeItemValue(stream, item);
 }
 
 // Get string representation of Loot
@@ -30,7 +30,7 @@ std::string Loot::toString() const {
     ss << position.toString();
     ss << ", ";
     ss << "item: ";
-    ss << item->toString();
+    ss << model::itemValueToString(item);
     ss << " }";
     return ss.str();
 }
@@ -19,9 +19,9 @@ public:
     // Position
     model::Vec2 position;
     // Item
-    std::shared_ptr<model::Item> item;
+    model::ItemValue item;
 
-    Loot(int id, model::Vec2 position, std::shared_ptr<model::Item> item);
+    Loot(int id, model::Vec2 position, model::ItemValue item);
 
     // Read Loot from input stream
     static Loot readFrom(InputStream& stream);
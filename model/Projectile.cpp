@@ -6,14 +6,20 @@ Projectile::Projectile(int id, int weaponTypeIndex, int shooterId, int shooterPl
 
 // Read Projectile from input stream
 Projectile Projectile::readFrom(InputStream& stream) {
-    int id = stream.readInt();
-    int weaponTypeIndex = stream.readInt();
-    int shooterId = stream.readInt();
-    int shooterPlayerId = stream.readInt();
-    model::Vec2 position = model::Vec2::readFrom(stream);
-    model::Vec2 velocity = model::Vec2::readFrom(stream);
-    double lifeTime = stream.readDouble();
-    return Projectile(id, weaponTypeIndex, shooterId, shooterPlayerId, position, velocity, lifeTime);
+    // fixed size on the wire, read at once
+    char bytes[4 * sizeof(int) + 5 * sizeof(double)];
+    stream.readBytes(bytes, sizeof(bytes));
+    ByteReader reader(bytes);
+    int id = reader.readInt();
+    int weaponTypeIndex = reader.readInt();
+    int shooterId = reader.readInt();
+    int shooterPlayerId = reader.readInt();
+    double positionX = reader.readDouble();
+    double positionY = reader.readDouble();
+    double velocityX = reader.readDouble();
+    double velocityY = reader.readDouble();
+    double lifeTime = reader.readDouble();
+    return Projectile(id, weaponTypeIndex, shooterId, shooterPlayerId, model::Vec2(positionX, positionY), model::Vec2(velocityX, velocityY), lifeTime);
 }
 
 // Write Projectile to output stream
@@ -20,9 +20,9 @@ public:
     // Target view direction (vector length doesn't matter)
     model::Vec2 targetDirection;
     // Order to perform an action, or None
-    std::optional<std::shared_ptr<model::ActionOrder>> action;
+    std::optional<model::ActionOrderValue> action;
 
-    UnitOrder(model::Vec2 targetVelocity, model::Vec2 targetDirection, std::optional<std::shared_ptr<model::ActionOrder>> action);
+    UnitOrder(model::Vec2 targetVelocity, model::Vec2 targetDirection, std::optional<model::ActionOrderValue> action);
 
     // Read UnitOrder from input stream
     static UnitOrder readFrom(InputStream& stream);
@@ -6,9 +6,9 @@ Vec2::Vec2(double x, double y) : x(x), y(y) { }
 
 // Read Vec2 from input stream
 Vec2 Vec2::readFrom(InputStream& stream) {
-    double x = stream.readDouble();
-    double y = stream.readDouble();
-    return Vec2(x, y);
+    double xy[2];
+    stream.readDoubles(xy, 2);
+    return Vec2(xy[0], xy[1]);
 }
 
 // Write Vec2 to output stream
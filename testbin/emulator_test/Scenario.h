@@ -0,0 +1,89 @@
+#pragma once
+
+#include "model/Constants.hpp"
+#include "model/Game.hpp"
+
+#include <cmath>
+#include <optional>
+#include <random>
+#include <vector>
+
+// Deterministic synthetic game the emulator checks run on: 400 obstacles on a round map, two of my units
+// next to each other, three enemies, loot of every kind and a dozen projectiles around my units.
+// Everything but the obstacles changes with the tick, so consecutive ticks give different worlds.
+namespace Scenario {
+
+inline model::Constants MakeConstants() {
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> uniform(-1, 1);
+
+    std::vector<model::Obstacle> obstacles;
+    for (int i = 0; i < 400; ++i) {
+        double x, y;
+        do {
+            x = uniform(random) * 150;
+            y = uniform(random) * 150;
+        } while (x * x + y * y > 150 * 150);
+        obstacles.emplace_back(i, model::Vec2{x, y}, 1 + (uniform(random) + 1) * 2, i % 3 == 0, i % 4 == 0);
+    }
+
+    std::vector<model::WeaponProperties> weapons = {
+        {"Pistol", 4, 7, 0.2, 60, 180, 0.75, 50, 25, 0.4, 0, 3, 100},
+        {"Rifle", 8, 5, 0.4, 45, 90, 0.5, 60, 15, 0.5, 1, 4, 200},
+        {"Sniper", 1, 0.5, 1, 10, 45, 0.25, 120, 60, 0.6, 2, 5, 20},
+    };
+    std::vector<model::SoundProperties> sounds = {
+        {"Pistol", 60, 0.1}, {"Rifle", 60, 0.1}, {"Sniper", 60, 0.1},
+        {"Pistol hit", 30, 0.1}, {"Rifle hit", 30, 0.1}, {"Sniper hit", 30, 0.1},
+        {"Steps", 20, 0.1},
+    };
+    return model::Constants(30, 2, 200, 1, 10, 2, 100, 1, 0, 1, 100, 1, 5, 100, 50, 2, 50, 90, 60, true, 180, 5, 10, 5, 30, false,
+                            1, 1, 1, weapons, 0, 10, 2, 100, 1, sounds, 6, 20, obstacles);
+}
+
+constexpr int MY_ID = 0;
+constexpr int FIRST_UNIT_ID = 1;
+constexpr int SECOND_UNIT_ID = 2;
+
+inline model::Game MakeGame(int tick) {
+    std::mt19937 random(1000 + tick / 10);
+    std::uniform_real_distribution<double> uniform(-1, 1);
+    double time = tick / 30.0;
+
+    std::vector<model::Unit> units;
+    auto makeUnit = [&](int id, int playerId, model::Vec2 position, model::Vec2 velocity, std::optional<int> weapon) {
+        return model::Unit(id, playerId, 80, 40, 2, position, std::nullopt, velocity, {1, 0}, 0, std::nullopt, 0, weapon, tick,
+                           {10, 20, 5}, 1);
+    };
+    units.push_back(makeUnit(FIRST_UNIT_ID, MY_ID, {10 + std::cos(time) * 5, 10}, {0, 0}, 2));
+    units.push_back(makeUnit(SECOND_UNIT_ID, MY_ID, {14, 12 + std::sin(time) * 5}, {0, 0}, 1));
+    units.push_back(makeUnit(3, 1, {30 + std::sin(time) * 8, 20}, {3, 1}, 2));
+    units.push_back(makeUnit(4, 2, {-10, 25 + std::cos(time) * 8}, {-2, 2}, 0));
+    units.push_back(makeUnit(5, 1, {40, -5}, {0, 3}, std::nullopt));
+
+    std::vector<model::Loot> loot;
+    for (int i = 0; i < 60; ++i) {
+        model::ItemValue item = model::Item::ShieldPotions(2);
+        if (i % 3 == 0) {
+            item = model::Item::Weapon(i % 2 ? 2 : 1);
+        } else if (i % 3 == 1) {
+            item = model::Item::Ammo(i % 2 ? 2 : 0, 10);
+        }
+        loot.emplace_back(100 + i, model::Vec2{uniform(random) * 80, uniform(random) * 80}, item);
+    }
+
+    std::vector<model::Projectile> projectiles;
+    for (int i = 0; i < 12; ++i) {
+        double angle = uniform(random) * M_PI;
+        projectiles.emplace_back(1000 + tick * 20 + i, i % 3, 3, 1, model::Vec2{10 + uniform(random) * 20, 10 + uniform(random) * 20},
+                                 model::Vec2{std::cos(angle) * 50, std::sin(angle) * 50}, 0.4 + (uniform(random) + 1) * 0.2);
+    }
+
+    std::vector<model::Sound> sounds;
+    if (tick % 7 == 0) {
+        sounds.emplace_back(0, 1, model::Vec2{-30, -30.0 + tick % 11});
+    }
+    return model::Game(MY_ID, {}, tick, units, loot, projectiles, model::Zone({0, 0}, 200 - time, {5, 5}, 120), sounds);
+}
+
+}
@@ -1,35 +1,630 @@
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
+#include "MyStrategy.hpp"
+#include "Stream.hpp"
+#include "Scenario.h"
+#include "emulator/BatchEmulator.h"
+#include "emulator/Evaluation.h"
+#include "emulator/EvaluationPool.h"
+#include "emulator/LootIndex.h"
+#include "emulator/LootPicker.h"
+#include "emulator/Mcts.h"
+#include "emulator/Memory.h"
+#include "emulator/Sound.h"
+#include "emulator/Strategy.h"
+#include "emulator/Visibility.h"
 #include "emulator/World.h"
 
-int main() {
-    double a = 100.1;
-    double b = a;
-    std::cout << (a == a) << std::endl;
+// Checks the emulator shortcuts against the plain scalar emulation on the synthetic scenario.
+// Every check prints what it compared and returns the number of mismatches.
+namespace {
 
-    abort();
-    int emulationSteps = 201;
-    std::ofstream fout("test.output");
+constexpr int HORIZON_TICKS = 35;
+constexpr int ACTION_DURATION = 7;
+constexpr int N_ACTIONS = 5;
 
-    Emulator::TWorld world;
-    world.Load("world_seed_2.bin");
+bool SameDouble(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
 
-    int myUnitId;
-    for (const auto& [unitId, unit]: world.UnitById) {
-        if (unit.PlayerId == world.MyId) {
-            myUnitId = unitId;
-            break;
+bool SameScore(const Emulator::TScore& a, const Emulator::TScore& b) {
+    return SameDouble(a.HealthScore, b.HealthScore)
+        && a.CombatSafetyScore.value.has_value() == b.CombatSafetyScore.value.has_value()
+        && (!a.CombatSafetyScore.value || SameDouble(*a.CombatSafetyScore.value, *b.CombatSafetyScore.value))
+        && SameDouble(a.TargetDistanceScore, b.TargetDistanceScore)
+        && a.Mode == b.Mode;
+}
+
+// World of the tick prepared the way getUnitOrder prepares it. With teammateRandom both of my units get
+// random teammate plans, GoTo ones on every fourth tick; the planned unit always skips its own
+Emulator::TWorld MakeWorld(int tick, Emulator::TMemory& memory, std::mt19937* teammateRandom = nullptr) {
+    auto world = Emulator::TWorld::FormApi(Scenario::MakeGame(tick));
+    memory.Update(world);
+    memory.InjectKnowledge(world);
+    world.UpdateThreats();
+    world.UpdateLootIndex();
+    world.UpdateUnitsTargetLoot();
+    for (auto unitId: {Scenario::FIRST_UNIT_ID, Scenario::SECOND_UNIT_ID}) {
+        world.StateByUnitId[unitId].Sync(world);
+    }
+    if (teammateRandom) {
+        for (auto unitId: {Scenario::FIRST_UNIT_ID, Scenario::SECOND_UNIT_ID}) {
+            auto strategy = Emulator::GenerateRandomStrategy(world.CurrentTick, ACTION_DURATION, N_ACTIONS, *teammateRandom);
+            if (tick % 4 == 0) {
+                strategy.GoTo = Emulator::GetTarget(world, unitId, true);
+            }
+            world.TeammateStrategies.emplace_back(unitId, std::move(strategy));
         }
     }
+    return world;
+}
 
-    for (int i = 0; i < emulationSteps; ++i) {
-        fout << world.UnitById[myUnitId].Position << std::endl;
-
-        world.EmulateOrder(Emulator::TOrder{
-            .UnitId = myUnitId,
-            .TargetVelocity = Emulator::Vector2D{-1000, 0},
-            .TargetDirection = Emulator::Vector2D{world.UnitById[myUnitId].Direction.y, -world.UnitById[myUnitId].Direction.x},
+// Projectiles flying through the unit towards its teammate, so whether the teammate is hit depends on where
+// the planned unit moves
+void AddCrossfire(Emulator::TWorld& world, int unitId, int teammateId, int tick) {
+    const auto& unit = world.Units.Get(unitId);
+    auto toTeammate = world.Units.Get(teammateId).Position - unit.Position;
+    auto direction = toTeammate / abs(toTeammate);
+    for (int i = 0; i < 4; ++i) {
+        auto angle = (i - 1.5) * 0.1 + tick * 0.01;
+        auto velocity = Emulator::Vector2D{direction.x * std::cos(angle) - direction.y * std::sin(angle),
+                                           direction.x * std::sin(angle) + direction.y * std::cos(angle)} * 40;
+        world.Projectiles.InsertOrAssign({
+            .Id = 50000 + i,
+            .WeaponTypeIndex = i % 3,
+            .ShooterId = 3,
+            .ShooterPlayerId = 1,
+            .Position = unit.Position - velocity / 40 * (2 + i),
+            .Velocity = velocity,
+            .LifeTime = 1.0,
         });
     }
-}
\ No newline at end of file
+}
+
+std::vector<Emulator::TStrategy> MakeStrategies(const Emulator::TWorld& world, int unitId, int count, std::mt19937& random) {
+    std::vector<Emulator::TStrategy> strategies;
+    for (int i = 0; i < count; ++i) {
+        auto strategy = Emulator::GenerateRandomStrategy(world.CurrentTick, ACTION_DURATION, N_ACTIONS, random);
+        if (i % 5 == 0) {
+            strategy.GoTo = Emulator::GetTarget(world, unitId, true);
+        }
+        strategies.push_back(std::move(strategy));
+    }
+    return strategies;
+}
+
+// Bytes written to it are read back in order. Reads either point into the written bytes like TcpStream
+// or go through the copying InputStream::readSpan like the replay streams.
+class TMemoryStream : public InputStream, public OutputStream {
+public:
+    explicit TMemoryStream(bool inPlace): InPlace_(inPlace) {}
+
+    void writeBytes(const char* buffer, size_t byteCount) {
+        Bytes_.insert(Bytes_.end(), buffer, buffer + byteCount);
+    }
+
+    void flush() {}
+
+    void readBytes(char* buffer, size_t byteCount) {
+        if (Position_ + byteCount > Bytes_.size()) {
+            throw std::runtime_error("Read past the written bytes");
+        }
+        std::memcpy(buffer, Bytes_.data() + Position_, byteCount);
+        Position_ += byteCount;
+    }
+
+    std::span<const char> readSpan(size_t byteCount) {
+        if (!InPlace_) {
+            return InputStream::readSpan(byteCount);
+        }
+        if (Position_ + byteCount > Bytes_.size()) {
+            throw std::runtime_error("Read past the written bytes");
+        }
+        Position_ += byteCount;
+        return {Bytes_.data() + Position_ - byteCount, byteCount};
+    }
+
+    [[nodiscard]] bool AtEnd() const { return Position_ == Bytes_.size(); }
+
+private:
+    bool InPlace_;
+    std::vector<char> Bytes_;
+    size_t Position_{0};
+};
+
+bool SameVector(Emulator::Vector2D a, Emulator::Vector2D b) {
+    return SameDouble(a.x, b.x) && SameDouble(a.y, b.y);
+}
+
+bool SameUnit(const Emulator::TUnit& a, const Emulator::TUnit& b) {
+    return a.Id == b.Id && a.PlayerId == b.PlayerId && SameVector(a.Position, b.Position) && SameVector(a.Direction, b.Direction)
+        && SameVector(a.Velocity, b.Velocity) && SameDouble(a.Health, b.Health) && SameDouble(a.Shield, b.Shield)
+        && a.ExtraLives == b.ExtraLives && a.RemainingSpawnTime.has_value() == b.RemainingSpawnTime.has_value()
+        && (!a.RemainingSpawnTime || SameDouble(*a.RemainingSpawnTime, *b.RemainingSpawnTime)) && SameDouble(a.Aim, b.Aim)
+        && a.HealthRegenerationStartTick == b.HealthRegenerationStartTick && a.Weapon == b.Weapon && a.NextShotTick == b.NextShotTick
+        && a.Ammo == b.Ammo && a.ShieldPotions == b.ShieldPotions && a.Imaginable == b.Imaginable;
+}
+
+bool SameProjectile(const Emulator::TProjectile& a, const Emulator::TProjectile& b) {
+    return a.Id == b.Id && a.WeaponTypeIndex == b.WeaponTypeIndex && a.ShooterId == b.ShooterId && a.ShooterPlayerId == b.ShooterPlayerId
+        && SameVector(a.Position, b.Position) && SameVector(a.Velocity, b.Velocity) && SameDouble(a.LifeTime, b.LifeTime);
+}
+
+bool SameLoot(const Emulator::TLoot& a, const Emulator::TLoot& b) {
+    return a.Id == b.Id && SameVector(a.Position, b.Position) && a.Item == b.Item && a.WeaponType == b.WeaponType && a.Amount == b.Amount;
+}
+
+// Names of the parts of the two worlds that differ, empty if they are the same
+std::vector<std::string> CompareDecodedWorlds(const Emulator::TWorld& a, const Emulator::TWorld& b) {
+    std::vector<std::string> differences;
+    auto compare = [&differences](const std::string& name, bool same) {
+        if (!same) {
+            differences.push_back(name);
+        }
+    };
+    compare("my id", a.MyId == b.MyId);
+    compare("tick", a.CurrentTick == b.CurrentTick);
+    compare("zone", SameVector(a.Zone.currentCenter, b.Zone.currentCenter) && SameDouble(a.Zone.currentRadius, b.Zone.currentRadius)
+        && SameVector(a.Zone.nextCenter, b.Zone.nextCenter) && SameDouble(a.Zone.nextRadius, b.Zone.nextRadius));
+    compare("unit count", a.Units.Size() == b.Units.Size());
+    for (int slot = 0; slot < std::min(a.Units.Size(), b.Units.Size()); ++slot) {
+        compare("unit " + std::to_string(a.Units[slot].Id), SameUnit(a.Units[slot], b.Units[slot]));
+    }
+    compare("projectile count", a.Projectiles.Size() == b.Projectiles.Size());
+    for (int slot = 0; slot < std::min(a.Projectiles.Size(), b.Projectiles.Size()); ++slot) {
+        compare("projectile " + std::to_string(a.Projectiles[slot].Id), SameProjectile(a.Projectiles[slot], b.Projectiles[slot]));
+    }
+    compare("loot count", a.Loot.Size() == b.Loot.Size());
+    for (int slot = 0; slot < std::min(a.Loot.Size(), b.Loot.Size()); ++slot) {
+        compare("loot " + std::to_string(a.Loot[slot].Id), SameLoot(a.Loot[slot], b.Loot[slot]));
+    }
+    compare("preprocessed count", a.PreprocessedDataById.size() == b.PreprocessedDataById.size());
+    for (const auto& [unitId, data]: a.PreprocessedDataById) {
+        auto other = b.PreprocessedDataById.find(unitId);
+        compare("preprocessed " + std::to_string(unitId), other != b.PreprocessedDataById.end()
+            && data.InDanger == other->second.InDanger && data.Friends == other->second.Friends);
+    }
+    return differences;
+}
+
+// TWorld::ReadApi against FormApi of the same model::Game written in the wire format, the decoded world
+// is reused from tick to tick like in the runner
+int CheckDecode() {
+    int nTicks = 0;
+    int mismatches = 0;
+    for (bool inPlace: {true, false}) {
+        Emulator::TWorld decoded;
+        std::vector<Emulator::TSound> sounds;
+        for (int tick = 0; tick < 70; ++tick) {
+            auto game = Scenario::MakeGame(tick);
+            // the scenario leaves these optional fields empty
+            if (tick % 2) {
+                game.units.back().remainingSpawnTime = tick / 10.0;
+                game.units.back().action = model::Action(tick + 30, model::ActionType::LOOTING);
+            }
+            TMemoryStream stream(inPlace);
+            game.writeTo(stream);
+            decoded.ReadApi(stream, sounds);
+            ++nTicks;
+
+            auto differences = CompareDecodedWorlds(Emulator::TWorld::FormApi(game), decoded);
+            if (!stream.AtEnd()) {
+                differences.push_back("bytes left");
+            }
+            bool sameSounds = sounds.size() == game.sounds.size();
+            for (size_t i = 0; sameSounds && i < sounds.size(); ++i) {
+                auto expected = Emulator::TSound::FromApi(game.sounds[i]);
+                sameSounds = sounds[i].TypeIndex == expected.TypeIndex && sounds[i].UnitId == expected.UnitId
+                    && SameVector(sounds[i].Position, expected.Position);
+            }
+            if (!sameSounds) {
+                differences.push_back("sounds");
+            }
+
+            if (!differences.empty()) {
+                ++mismatches;
+                std::cerr << "decode: tick " << tick << (inPlace ? " in place" : " copied") << " differs in";
+                for (const auto& difference: differences) {
+                    std::cerr << " " << difference;
+                }
+                std::cerr << std::endl;
+            }
+        }
+    }
+
+    std::cout << "decode: " << nTicks << " ticks, " << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+// TBatchEmulator lanes against EvaluateStrategy: scores and the health of every unit must match bit for bit.
+// With teammates the lanes share the teammate step, the scalar emulation moves them on its own
+int CheckBatch(const std::string& name, bool teammates) {
+    std::mt19937 random(5);
+    std::mt19937 teammateRandom(19);
+    Emulator::TMemory memory;
+    Emulator::TBatchEmulator batch;
+    Emulator::TRollout rollout;
+
+    int nStrategies = 0;
+    int nSplitLanes = 0;
+    int mismatches = 0;
+    for (int tick = 0; tick < 60; tick += 2) {
+        auto world = MakeWorld(tick, memory, teammates ? &teammateRandom : nullptr);
+        for (auto [unitId, teammateId]: {std::pair{Scenario::FIRST_UNIT_ID, Scenario::SECOND_UNIT_ID},
+                                         std::pair{Scenario::SECOND_UNIT_ID, Scenario::FIRST_UNIT_ID}}) {
+            auto crossfireWorld = world;
+            AddCrossfire(crossfireWorld, unitId, teammateId, tick);
+            rollout.Reset(crossfireWorld);
+            const auto& root = rollout.Root();
+            int untilTick = root.CurrentTick + HORIZON_TICKS;
+
+            auto strategies = MakeStrategies(root, unitId, 3 * Emulator::BATCH_SIZE + 5, random);
+            for (int begin = 0; begin < static_cast<int>(strategies.size()); begin += Emulator::BATCH_SIZE) {
+                int nLanes = std::min<int>(Emulator::BATCH_SIZE, strategies.size() - begin);
+                std::array<const Emulator::TStrategy*, Emulator::BATCH_SIZE> lanes;
+                for (int lane = 0; lane < nLanes; ++lane) {
+                    lanes[lane] = &strategies[begin + lane];
+                }
+                std::array<Emulator::TScore, Emulator::BATCH_SIZE> scores;
+                batch.Evaluate(lanes.data(), nLanes, rollout, unitId, untilTick, scores.data());
+
+                for (int lane = 0; lane < nLanes; ++lane) {
+                    ++nStrategies;
+                    Emulator::TScore score = {0, {std::nullopt}, 0};
+                    Emulator::EmulateStrategy(*lanes[lane], rollout.World(), root, unitId, untilTick, score);
+                    if (!SameScore(score, scores[lane])) {
+                        ++mismatches;
+                        std::cerr << name << ": tick " << tick << " unit " << unitId << " strategy " << begin + lane << " score differs" << std::endl;
+                    }
+                    bool split = false;
+                    for (int slot = 0; slot < rollout.World().Units.Size(); ++slot) {
+                        auto health = rollout.World().Units[slot].Health;
+                        split |= slot != root.Units.GetSlot(unitId) && health != batch.GetUnitHealth(slot, 0);
+                        if (!SameDouble(health, batch.GetUnitHealth(slot, lane))) {
+                            ++mismatches;
+                            std::cerr << name << ": tick " << tick << " unit " << unitId << " strategy " << begin + lane
+                                      << " health of unit " << rollout.World().Units[slot].Id << " differs" << std::endl;
+                        }
+                    }
+                    nSplitLanes += split;
+                    rollout.Rewind();
+                }
+            }
+        }
+    }
+
+    std::cout << name << ": " << nStrategies << " strategies, " << nSplitLanes << " with other units' health apart from lane 0, "
+              << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+// TEvaluationPool::EvaluateCached against EvaluateStrategy on mutations of one strategy and of each other,
+// like the mutation phase of getUnitOrder. The second pass over the same list resumes from the deepest boundaries
+int CheckPrefix() {
+    std::mt19937 random(13);
+    Emulator::TMemory memory;
+    Emulator::TEvaluationPool pool(4);
+    Emulator::TRollout rollout;
+
+    int nStrategies = 0;
+    int mismatches = 0;
+    for (int tick = 0; tick < 60; tick += 3) {
+        auto world = MakeWorld(tick, memory);
+        for (auto unitId: {Scenario::FIRST_UNIT_ID, Scenario::SECOND_UNIT_ID}) {
+            pool.SetWorld(world, tick);
+            rollout.Reset(world);
+            int untilTick = world.CurrentTick + HORIZON_TICKS;
+
+            auto base = Emulator::GenerateRandomStrategy(world.CurrentTick, ACTION_DURATION, N_ACTIONS, random);
+            std::vector<Emulator::TStrategy> mutations;
+            for (int i = 0; i < 32; ++i) {
+                const auto& parent = i % 2 && !mutations.empty() ? mutations[random() % mutations.size()] : base;
+                mutations.push_back(parent.Mutate(random));
+            }
+
+            for (int pass = 0; pass < 2; ++pass) {
+                auto scores = pool.EvaluateCached(mutations, unitId, untilTick, std::chrono::high_resolution_clock::time_point::max());
+                for (size_t i = 0; i < mutations.size(); ++i) {
+                    ++nStrategies;
+                    auto score = Emulator::EvaluateStrategy(mutations[i], rollout, unitId, untilTick);
+                    if (!scores[i] || !SameScore(*scores[i], score)) {
+                        ++mismatches;
+                        std::cerr << "prefix: tick " << tick << " unit " << unitId << " pass " << pass << " mutation " << i
+                                  << " score differs" << std::endl;
+                    }
+                }
+            }
+
+            // nothing is started once the deadline has passed
+            auto late = pool.EvaluateCached(mutations, unitId, untilTick, std::chrono::high_resolution_clock::now());
+            if (std::any_of(late.begin(), late.end(), [](const auto& score) { return score.has_value(); })) {
+                ++mismatches;
+                std::cerr << "prefix: tick " << tick << " unit " << unitId << " evaluated after the deadline" << std::endl;
+            }
+        }
+    }
+
+    std::cout << "prefix: " << nStrategies << " strategies, " << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+// Score of the best sequence TMctsTree reports against EvaluateStrategy of that sequence. The trees live through
+// consecutive ticks, so scores resumed from node checkpoints and subtrees kept by re-rooting are covered
+int CheckMcts() {
+    std::mt19937 random(17);
+    Emulator::TMemory memory;
+    Emulator::TRollout rollout;
+    std::map<int, Emulator::TMctsTree> treeByUnitId;
+    std::map<int, std::optional<Emulator::TMctsExecutedAction>> executedByUnitId;
+
+    int nSearches = 0;
+    int nIterations = 0;
+    int mismatches = 0;
+    for (int tick = 0; tick < 42; ++tick) {
+        auto world = MakeWorld(tick, memory);
+        for (auto unitId: {Scenario::FIRST_UNIT_ID, Scenario::SECOND_UNIT_ID}) {
+            rollout.Reset(world);
+            int untilTick = world.CurrentTick + HORIZON_TICKS;
+            auto& tree = treeByUnitId[unitId];
+            tree.Prepare(world.CurrentTick, ACTION_DURATION, executedByUnitId[unitId]);
+            auto result = tree.Search(rollout, random, {
+                .UnitId = unitId,
+                .UntilTick = untilTick,
+                .ActionDuration = ACTION_DURATION,
+                .Iterations = 64,
+                .Deadline = std::chrono::high_resolution_clock::time_point::max(),
+            });
+            ++nSearches;
+            nIterations += result.Iterations;
+            if (!result.Best) {
+                ++mismatches;
+                std::cerr << "mcts: tick " << tick << " unit " << unitId << " found nothing" << std::endl;
+                continue;
+            }
+            auto score = Emulator::EvaluateStrategy(result.Best->Strategy, rollout, unitId, untilTick);
+            if (!SameScore(score, result.Best->Score)) {
+                ++mismatches;
+                std::cerr << "mcts: tick " << tick << " unit " << unitId << " best score differs" << std::endl;
+            }
+            // the unit follows the best sequence, so the next slot keeps its subtree
+            executedByUnitId[unitId] = Emulator::TMctsExecutedAction{
+                .Tick = world.CurrentTick,
+                .Speed = result.Best->Strategy.GetAction(world, unitId, world.CurrentTick).Speed,
+            };
+        }
+    }
+
+    std::cout << "mcts: " << nSearches << " searches, " << nIterations << " iterations, " << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+// TLootIndex::FindNearest against a linear scan in build order that only takes strictly closer loot.
+// Loot snapped to a coarse lattice and queried from lattice points gives plenty of exact ties.
+int CheckLootIndex() {
+    std::mt19937 random(11);
+    std::uniform_real_distribution<double> coordinate(-120, 120);
+    std::uniform_int_distribution<int> lattice(-25, 25);
+    Emulator::TMemory memory;
+    Emulator::TLootIndex index;
+
+    int nQueries = 0;
+    int nFound = 0;
+    int mismatches = 0;
+    for (int tick = 0; tick < 60; tick += 3) {
+        auto world = MakeWorld(tick, memory);
+        for (bool snapped: {false, true}) {
+            std::vector<Emulator::TIndexedLoot> loot;
+            for (const auto& item: world.Loot) {
+                auto position = snapped ? Emulator::Vector2D{std::round(item.Position.x / 4) * 4, std::round(item.Position.y / 4) * 4}
+                                        : item.Position;
+                loot.push_back({item.Id, position});
+                // a second loot on the same spot, found later in the build order
+                if (item.Id % 3 == 0) {
+                    loot.push_back({item.Id + 10000, position});
+                }
+            }
+            index.Build(loot);
+
+            for (int query = 0; query < 500; ++query) {
+                Emulator::Vector2D point = snapped ? Emulator::Vector2D{lattice(random) * 2.0, lattice(random) * 2.0}
+                                                   : Emulator::Vector2D{coordinate(random), coordinate(random)};
+                int rejectRemainder = query % 4;
+                auto accept = [rejectRemainder](int lootId) { return lootId % 4 != rejectRemainder; };
+                // detours for some loot, never shorter than the straight line
+                auto distance2 = [point, query](int lootId, Emulator::Vector2D position) {
+                    return abs2(position - point) * (query % 2 && lootId % 5 == 0 ? 2 : 1);
+                };
+                std::optional<double> initialDist2;
+                if (query % 3 == 0) {
+                    initialDist2 = abs2(loot[query % loot.size()].Position - point);
+                }
+
+                std::optional<double> expectedDist2 = initialDist2;
+                std::optional<int> expected;
+                for (const auto& item: loot) {
+                    auto dist2 = std::max(abs2(item.Position - point), distance2(item.LootId, item.Position));
+                    if ((!expectedDist2 || dist2 < *expectedDist2) && accept(item.LootId)) {
+                        expectedDist2 = dist2;
+                        expected = item.LootId;
+                    }
+                }
+
+                auto minDist2 = initialDist2;
+                auto found = index.FindNearest(point, minDist2, accept, distance2);
+                ++nQueries;
+                nFound += found.has_value();
+                if (found != expected || minDist2.has_value() != expectedDist2.has_value()
+                    || (minDist2 && !SameDouble(*minDist2, *expectedDist2))) {
+                    ++mismatches;
+                    std::cerr << "loot_index: tick " << tick << " point " << point << " found " << found.value_or(-1)
+                              << " instead of " << expected.value_or(-1) << std::endl;
+                }
+            }
+        }
+    }
+
+    std::cout << "loot_index: " << nQueries << " queries, " << nFound << " found, " << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+// Not a check: time of TBatchEmulator and of EvaluateStrategy on the same strategies, 800 per world
+// like a decision of a few workers. Meaningful in a Release build only, fails only if the scores differ
+int Benchmark() {
+    constexpr int N_WORLDS = 10;
+    constexpr int N_STRATEGIES = 800;
+    std::mt19937 random(23);
+    Emulator::TMemory memory;
+    Emulator::TBatchEmulator batch;
+    Emulator::TRollout rollout;
+
+    // the visibility builder would compete for the cpu
+    Emulator::GetGlobalVisibilityMap()->WaitUntilBuilt();
+
+    std::chrono::nanoseconds scalarTime{0};
+    std::chrono::nanoseconds batchTime{0};
+    double scalarSum = 0;
+    double batchSum = 0;
+    for (int i = 0; i < N_WORLDS; ++i) {
+        auto world = MakeWorld(i * 6, memory);
+        int unitId = i % 2 ? Scenario::SECOND_UNIT_ID : Scenario::FIRST_UNIT_ID;
+        rollout.Reset(world);
+        int untilTick = world.CurrentTick + HORIZON_TICKS;
+        auto strategies = MakeStrategies(rollout.Root(), unitId, N_STRATEGIES, random);
+
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& strategy: strategies) {
+            scalarSum += Emulator::EvaluateStrategy(strategy, rollout, unitId, untilTick).TargetDistanceScore;
+        }
+        scalarTime += std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (int begin = 0; begin < N_STRATEGIES; begin += Emulator::BATCH_SIZE) {
+            std::array<const Emulator::TStrategy*, Emulator::BATCH_SIZE> lanes;
+            for (int lane = 0; lane < Emulator::BATCH_SIZE; ++lane) {
+                lanes[lane] = &strategies[begin + lane];
+            }
+            std::array<Emulator::TScore, Emulator::BATCH_SIZE> scores;
+            batch.Evaluate(lanes.data(), Emulator::BATCH_SIZE, rollout, unitId, untilTick, scores.data());
+            for (const auto& score: scores) {
+                batchSum += score.TargetDistanceScore;
+            }
+        }
+        batchTime += std::chrono::steady_clock::now() - start;
+    }
+
+    auto scalarMs = std::chrono::duration<double, std::milli>(scalarTime).count() / N_WORLDS;
+    auto batchMs = std::chrono::duration<double, std::milli>(batchTime).count() / N_WORLDS;
+    std::cout << "bench: " << N_STRATEGIES << " strategies of " << HORIZON_TICKS << " ticks per world, scalar " << scalarMs
+              << "ms, batch " << batchMs << "ms, speed-up " << scalarMs / batchMs << (scalarSum == batchSum ? "" : ", scores differ") << std::endl;
+    return scalarSum == batchSum ? 0 : 1;
+}
+
+// TVisibilityMap against the obstacle walk on random lines up to the longest weapon range
+int CheckVisibility() {
+    const auto* constants = Emulator::GetGlobalConstants();
+    const auto* visibility = Emulator::GetGlobalVisibilityMap();
+    // the builder runs in the background, a line it has not reached yet would simply not be answered
+    visibility->WaitUntilBuilt();
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> coordinate(-140, 140);
+    std::uniform_real_distribution<double> offset(-60, 60);
+    std::vector<std::pair<Emulator::Vector2D, Emulator::Vector2D>> lines;
+    for (int i = 0; i < 100000; ++i) {
+        Emulator::Vector2D from{coordinate(random), coordinate(random)};
+        lines.emplace_back(from, Emulator::Vector2D{from.x + offset(random), from.y + offset(random)});
+    }
+
+    int nCovered = 0;
+    for (const auto& [from, to]: lines) {
+        nCovered += visibility->Covers(from, to);
+    }
+
+    int nAnswered = 0;
+    int mismatches = 0;
+    std::chrono::nanoseconds walkTime{0};
+    std::chrono::nanoseconds tableTime{0};
+    for (auto kind: {Emulator::LINE_OF_SIGHT, Emulator::LINE_OF_FIRE}) {
+        std::vector<char> exact;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& [from, to]: lines) {
+            exact.push_back(!constants->obstaclesMeta.SegmentIntersectsObstacle(from, to, kind));
+        }
+        walkTime += std::chrono::steady_clock::now() - start;
+
+        std::vector<std::optional<bool>> cached;
+        start = std::chrono::steady_clock::now();
+        for (const auto& [from, to]: lines) {
+            cached.push_back(visibility->IsLineClear(from, to, kind));
+        }
+        tableTime += std::chrono::steady_clock::now() - start;
+
+        for (size_t i = 0; i < lines.size(); ++i) {
+            if (!cached[i]) {
+                continue;
+            }
+            ++nAnswered;
+            if (*cached[i] != static_cast<bool>(exact[i])) {
+                ++mismatches;
+                std::cerr << "visibility: line " << lines[i].first << " " << lines[i].second << " kind " << kind << " differs" << std::endl;
+            }
+        }
+    }
+
+    // the table is complete, every line it covers must be answered
+    if (nAnswered != 2 * nCovered) {
+        ++mismatches;
+        std::cerr << "visibility: " << nAnswered << " lines answered out of " << 2 * nCovered << " covered" << std::endl;
+    }
+
+    std::cout << "visibility: " << 2 * lines.size() << " lines, " << nAnswered << " answered by the table, "
+              << std::chrono::duration<double, std::milli>(walkTime).count() << "ms walking, "
+              << std::chrono::duration<double, std::milli>(tableTime).count() << "ms in the table, "
+              << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    srand(239);
+    MyStrategy strategy(Scenario::MakeConstants());
+
+    std::vector<std::pair<std::string, std::function<int()>>> checks = {
+        {"batch", [] { return CheckBatch("batch", false); }},
+        {"batch_teammates", [] { return CheckBatch("batch_teammates", true); }},
+        {"decode", CheckDecode},
+        {"loot_index", CheckLootIndex},
+        {"mcts", CheckMcts},
+        {"prefix", CheckPrefix},
+        {"visibility", CheckVisibility},
+        {"bench", Benchmark},
+    };
+
+    std::string only = argc > 1 ? argv[1] : "";
+    int failures = 0;
+    bool found = false;
+    for (const auto& [name, check]: checks) {
+        if (!only.empty() && name != only) {
+            continue;
+        }
+        found = true;
+        failures += check();
+    }
+    if (!found) {
+        std::cerr << "unknown check " << only << std::endl;
+        return 1;
+    }
+    return failures ? 1 : 0;
+}
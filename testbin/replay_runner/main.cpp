@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "MyStrategy.hpp"
+#include "ReplayStream.hpp"
+#include "codegame/ServerMessage.hpp"
+#include "emulator/Sound.h"
+#include "emulator/World.h"
+
+// Feeds a replay recorded with `ai_cup_22 <host> <port> <token> <replay>` back into MyStrategy and reports
+// how long every getOrder took. Debug updates are skipped, orders are thrown away.
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <replay>" << std::endl;
+        return 1;
+    }
+
+    srand(239);
+
+    FileInputStream input(argv[1]);
+    readReplayHeader(input);
+
+    std::unique_ptr<MyStrategy> myStrategy;
+    std::vector<double> tickMilliseconds;
+
+    Emulator::TWorld world;
+    std::vector<Emulator::TSound> sounds;
+
+    // same message handling as Runner in main.cpp, decoding time is part of the tick
+    while (!input.atEnd()) {
+        int tag = input.readInt();
+        // a truncated or corrupt replay may ask for orders before the game is set up
+        bool needsStrategy = tag == codegame::ServerMessage::GetOrder::TAG || tag == codegame::ServerMessage::Finish::TAG;
+        if (needsStrategy && !myStrategy) {
+            std::cerr << "unexpected server message" << std::endl;
+            return 1;
+        }
+        if (tag == codegame::ServerMessage::GetOrder::TAG) {
+            auto start = std::chrono::steady_clock::now();
+            world.ReadApi(input, sounds);
+            input.readBool();
+            myStrategy->getOrder(world, sounds, nullptr);
+            auto finish = std::chrono::steady_clock::now();
+            tickMilliseconds.push_back(std::chrono::duration<double, std::milli>(finish - start).count());
+        } else if (tag == codegame::ServerMessage::UpdateConstants::TAG) {
+            myStrategy = std::make_unique<MyStrategy>(codegame::ServerMessage::UpdateConstants::readFrom(input).constants);
+        } else if (tag == codegame::ServerMessage::Finish::TAG) {
+            myStrategy->finish();
+            break;
+        } else if (tag != codegame::ServerMessage::DebugUpdate::TAG) {
+            std::cerr << "unexpected server message" << std::endl;
+            return 1;
+        }
+    }
+
+    if (tickMilliseconds.empty()) {
+        std::cerr << "no ticks in the replay" << std::endl;
+        return 1;
+    }
+
+    double total = 0;
+    for (auto milliseconds: tickMilliseconds) {
+        total += milliseconds;
+    }
+    std::sort(tickMilliseconds.begin(), tickMilliseconds.end());
+    auto percentile = [&](double p) {
+        return tickMilliseconds[std::min(tickMilliseconds.size() - 1, static_cast<size_t>(p * tickMilliseconds.size()))];
+    };
+
+    std::cout << "ticks " << tickMilliseconds.size() << std::endl;
+    std::cout << "total ms " << total << std::endl;
+    std::cout << "mean ms " << total / tickMilliseconds.size() << std::endl;
+    std::cout << "p50 ms " << percentile(0.5) << std::endl;
+    std::cout << "p99 ms " << percentile(0.99) << std::endl;
+    std::cout << "max ms " << tickMilliseconds.back() << std::endl;
+    return 0;
+}